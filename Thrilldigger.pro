@@ -23,7 +23,24 @@ SOURCES += src/main.cpp \
     src/solverwindow.cpp \
     src/solver.cpp \
     src/partitioniterator.cpp \
-    src/benchmark.cpp
+    src/benchmark.cpp \
+    src/streamingstatistics.cpp \
+    src/neighborsumkernel.cpp \
+    src/movestrategy.cpp \
+    src/neighbortable.cpp \
+    src/presetsolver.cpp \
+    src/columnsweep.cpp \
+    src/variableelimination.cpp \
+    src/frontier.cpp \
+    src/transpositioncache.cpp \
+    src/persistentcache.cpp \
+    src/openingbook.cpp \
+    src/solverworker.cpp \
+    src/boardwidget.cpp \
+    src/boardsampler.cpp \
+    src/rolloutevaluator.cpp \
+    src/optimalplay.cpp \
+    src/boarddatabase.cpp
 
 HEADERS  += \
     headers/settingswindow.h \
@@ -36,7 +53,26 @@ HEADERS  += \
     headers/constraint.h \
     headers/partition.h \
     headers/partitioniterator.h \
-    headers/benchmark.h
+    headers/benchmark.h \
+    headers/streamingstatistics.h \
+    headers/neighborsumkernel.h \
+    headers/movestrategy.h \
+    headers/neighbortable.h \
+    headers/presetsolver.h \
+    headers/frontier.h \
+    headers/columnsweep.h \
+    headers/variableelimination.h \
+    headers/transpositioncache.h \
+    headers/persistentcache.h \
+    headers/openingbook.h \
+    headers/solverworker.h \
+    headers/solversnapshot.h \
+    headers/boardwidget.h \
+    headers/boardsampler.h \
+    headers/rolloutevaluator.h \
+    headers/optimalplay.h \
+    headers/boarddatabase.h \
+    headers/weightarithmetic.h
 
 FORMS    += \
     forms/settingswindow.ui \
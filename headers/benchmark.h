@@ -2,18 +2,58 @@
 
 #include "board.h"
 #include "dugtype.h"
+#include "movestrategy.h"
+#include "neighborsumkernel.h"
 #include "problemparameters.h"
 #include "solver.h"
+#include "streamingstatistics.h"
 #include <QMap>
 #include <QObject>
 #include <QThread>
 #include <array>
+#include <memory>
+#include <vector>
+
+struct BenchmarkStatistics {
+    explicit BenchmarkStatistics(const ProblemParameters &params);
+
+    void addClick(int click, int constrainedHoles, int partitions);
+    void addPick(double probability, bool goneBad);
+    void merge(const BenchmarkStatistics &other);
+
+    static constexpr int probabilityBuckets = 20;
+
+    std::vector<StreamingStatistics> constrainedHolesOnClicks;
+    std::vector<StreamingStatistics> partitionsOnClicks;
+    std::vector<StreamingStatistics> probabilityOnBuckets;
+    std::vector<StreamingStatistics> goneBadOnBuckets;
+
+    int games = 0;
+    int wins = 0;
+    int totalBadSpots = 0;
+    int totalClicks = 0;
+    uint64_t totalRupees = 0;
+    double totalProbabilities = 0.0;
+};
+
+// The slow parts of a benchmark, all off by default.
+struct BenchmarkOptions {
+    // Plays every seed with RolloutStrategy as well.
+    bool rollouts = false;
+    // Solves optimal play exactly after the runs, on boards small enough
+    // for OptimalPlay.
+    bool optimalPlay = false;
+    // Solves every position by partition enumeration in exact counts
+    // instead of the automatic engine, to compare against a default run.
+    bool exactCounts = false;
+};
 
 class Benchmark : public QObject
 {
     Q_OBJECT
 public:
-    explicit Benchmark(const ProblemParameters &params);
+    explicit Benchmark(const ProblemParameters &params,
+                       const BenchmarkOptions &options = BenchmarkOptions());
 
     void start();
 
@@ -23,15 +63,10 @@ signals:
 
 public slots:
     void run();
-    void singleRun();
 
 private:
-    QMap<double, int> probabilityCount;
-    QMap<double, int> probabilityGoneBad;
     QMap<int, int> constrainedHolesEncountered;
     QMap<int, double> constrainedHolesTotalTime;
-    QMap<int, int> clicksEncountered;
-    QMap<int, double> totalSetupTimeForClicks;
     QMap<int, int> partitionsEncountered;
     QMap<int, double> totalTimeOnPartitions;
     QMap<uint64_t, int> standardIterationsEncountered;
@@ -40,22 +75,22 @@ private:
     QMap<int, int> legalIterationsEncountered;
     QMap<int, double> totalTimeOnLegalIterations;
 
-    QMap<int, QList<int> *> constrainedHolesOnClicks;
-    QMap<int, QList<int> *> partitionsOnClicks;
+    std::vector<std::unique_ptr<MoveStrategy>> strategies;
+    std::vector<BenchmarkStatistics> statistics;
 
-    int totalBadSpots;
-    int wins;
     uint64_t totalSetupTime;
     uint64_t totalRunTime;
-    double totalProbabilities;
-    uint64_t totalRupees;
-    int totalClicks;
     QThread thread;
     const std::vector<double> *probabilityArray;
     ProblemParameters params;
+    BenchmarkOptions options;
     Board board;
     Solver solver;
-    DugType::DugType **knownBoard;
+    NeighborSumKernel neighborSums;
+    std::vector<DugType::DugType> knownBoard;
 
     std::array<double, 4> ridgepoints = {0.5, 2.5, 4.5, 6.5};
+
+    void singleRun(const MoveStrategy &strategy,
+                   BenchmarkStatistics &statistics);
 };
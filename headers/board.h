@@ -3,20 +3,34 @@
 
 #include "problemparameters.h"
 #include "vector2d.h"
+#include <cstdint>
+#include <memory>
+
+class NeighborTable;
 
 class Board
 {
 
 public:
     explicit Board(const ProblemParameters &params);
+    // A board with the bombs and rupoors of `layout`, one row-major entry per
+    // cell; every other cell holds the rupee its neighbours call for.
+    Board(const ProblemParameters &params, const DugType::DugType *layout);
 
     DugType::DugType getCell(int x, int y) &;
     bool hasWon() const &;
 
     void reload() &;
+    void reload(uint32_t seed) &;
+    // Starts over on the bombs and rupoors of `layout`, as the constructor
+    // taking a layout does.
+    void load(const DugType::DugType *layout) &;
 
 private:
     ProblemParameters problemParams_;
+    std::shared_ptr<const NeighborTable> neighbors_;
     Vector2d<bool> opened_;
     Vector2d<DugType::DugType> boardRep_;
+
+    void colourRupees();
 };
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+#include "dugtype.h"
+#include "problemparameters.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Every layout of the bad spots on a small board, bombs and rupoors counted
+// together, with what each cell shows in it. The clues are stored column
+// by column: for every cell and everything it can show, bad or one of the
+// five rupees, a bitset with one bit per layout. A position is answered by
+// AND-ing the bitsets of its opened cells and counting, for every cell, the
+// surviving layouts in which it is bad, so nothing is enumerated at solve
+// time.
+class BoardDatabase
+{
+public:
+    // Intermediate's 5.9 million layouts fit; the bitsets then take about
+    // 130 MB.
+    static constexpr uint64_t maxLayouts = uint64_t(1) << 23;
+    // Up to here a query is cheaper than any frontier engine, so the
+    // automatic engine prefers the database.
+    static constexpr uint64_t smallLayouts = uint64_t(1) << 16;
+
+    explicit BoardDatabase(const ProblemParameters &params);
+
+    // The number of layouts of `params`, or maxLayouts + 1 if there are more.
+    static uint64_t layoutCount(const ProblemParameters &params);
+    static bool isSuitable(const ProblemParameters &params);
+    // The shared database for `params`, built on first use, or nullptr when
+    // the board is not suitable.
+    static std::shared_ptr<const BoardDatabase>
+    forParameters(const ProblemParameters &params);
+
+    // `types` holds one row-major entry per cell. Fills badWeight[i] with
+    // the number of layouts agreeing with the position in which cell i is
+    // bad, and returns the number of layouts agreeing with it. `consistent`
+    // is scratch space, so that concurrent queries need no locking.
+    double solve(const DugType::DugType *types,
+                 std::vector<double> &badWeight,
+                 std::vector<uint64_t> &consistent) const;
+
+private:
+    // Bad, then green to gold.
+    static constexpr int clueCount = 6;
+
+    int numHoles_;
+    uint64_t layouts_;
+    size_t words_;
+    std::vector<uint64_t> bits_;
+
+    uint64_t *clueBits(int cell, int clue);
+    const uint64_t *clueBits(int cell, int clue) const;
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include "board.h"
+#include "dugtype.h"
+#include "problemparameters.h"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+class Solver;
+
+// Draws complete layouts uniformly from those consistent with a position.
+// Frontier holes sharing the same constraints form classes, and classes
+// linked by constraints form components. Every component gets count tables
+// over its classes in visiting order, and a table over the components and
+// the unconstrained holes fixes each component's bad count exactly; a sample
+// then walks the tables once, so it costs time linear in the board and
+// nothing is rejected.
+class BoardSampler
+{
+public:
+    static constexpr int maxTableEntries = 1 << 22;
+
+    explicit BoardSampler(const ProblemParameters &params);
+
+    // Builds the tables for the current position of `solver`. Returns false
+    // when no layout agrees with the position, or when the count tables
+    // would need more than maxTableEntries entries.
+    bool prepare(Solver &solver);
+
+    // Fills `layout` with one row-major entry per cell: bomb, rupoor, or
+    // green for every cell that holds neither.
+    void sample(std::mt19937 &rng, std::vector<DugType::DugType> &layout) const;
+    // A board holding a sampled layout, with the revealed cells opened.
+    Board sampleBoard(std::mt19937 &rng) const;
+
+private:
+    struct HoleClass {
+        std::vector<int> holes;
+        std::vector<int> constraints;
+    };
+
+    // Layer t lies before the t-th class. Its states hold the bad counts of
+    // the constraints open across it; next[t] maps a state and the bad count
+    // of class t to a state of layer t + 1, or -1 when a constraint breaks.
+    // From a state, classes t onwards can finish with low to high bad spots;
+    // ways[t] weighs each of those counts, from offsets[t] on, and is scaled
+    // independently of the other layers. counts is the first layer's only
+    // state, by total bad count.
+    struct Component {
+        std::vector<int> classes;
+        std::vector<std::vector<int>> next;
+        std::vector<std::vector<int>> low;
+        std::vector<std::vector<int>> high;
+        std::vector<std::vector<int>> offsets;
+        std::vector<std::vector<double>> ways;
+        std::vector<double> counts;
+    };
+
+    ProblemParameters params_;
+    int numHoles_;
+    std::vector<DugType::DugType> revealed_;
+    std::vector<int> knownBad_;
+    std::vector<int> unconstrained_;
+    std::vector<HoleClass> classes_;
+    std::vector<Component> components_;
+    // tails_[c][used] weighs the ways for components c onwards and the
+    // unconstrained holes to complete `used` bad spots; rows are scaled
+    // independently, as only ratios within a row are read.
+    std::vector<std::vector<double>> tails_;
+    int badSpots_ = 0;
+    int hiddenBombs_ = 0;
+    // Per constraint while building tables: the class positions it spans,
+    // its holes in classes not yet placed and its place in the open state.
+    std::vector<int> first_;
+    std::vector<int> last_;
+    std::vector<int> remaining_;
+    std::vector<int> openPosition_;
+
+    void buildClasses(const std::vector<int> &holes,
+                      const std::vector<std::vector<int>> &constraintHoles);
+    bool buildComponents(const std::vector<std::vector<int>> &constraintHoles,
+                         const std::vector<int> &maxBadness);
+    bool buildTables(Component &component,
+                     const std::vector<int> &maxBadness,
+                     int &entries);
+    bool buildTails();
+    double waysOf(const Component &component, int t, int state, int bad) const;
+};
@@ -0,0 +1,68 @@
+#pragma once
+#include "dugtype.h"
+#include <QWidget>
+#include <vector>
+
+class QFocusEvent;
+class QKeyEvent;
+class QMouseEvent;
+class QPaintEvent;
+
+// Paints a whole board in one widget instead of a widget per cell. Setters
+// only schedule a repaint of the cells whose contents changed, and painting
+// walks only the cells inside the exposed region, so large boards open and
+// refresh without per-cell widgets or style sheets.
+//
+// A cell is activated by a left click, or by Enter or Space on the keyboard
+// cursor, which the arrow keys move. An editable board asks for a cell type
+// in a menu instead, and also takes the digits 0 to 7 for the types from
+// undug to gold.
+class BoardWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit BoardWidget(QWidget *parent = nullptr);
+
+    void resizeBoard(int width, int height);
+    void setEditable(bool editable);
+
+    DugType::DugType cell(int x, int y) const;
+    void setCell(int x, int y, DugType::DugType type);
+    // Probabilities are shown on undug cells; `lowestRisk` cells are
+    // highlighted.
+    void setProbabilities(const std::vector<double> &probabilities,
+                          const std::vector<int> &lowestRisk);
+
+    QSize sizeHint() const override;
+    QSize minimumSizeHint() const override;
+
+signals:
+    void cellActivated(int x, int y);
+    void cellEdited(int x, int y, DugType::DugType type);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void focusInEvent(QFocusEvent *event) override;
+    void focusOutEvent(QFocusEvent *event) override;
+
+private:
+    struct Cell {
+        DugType::DugType type = DugType::undug;
+        double probability = -1.0;
+        bool highlighted = false;
+    };
+
+    int boardWidth_ = 0;
+    int boardHeight_ = 0;
+    bool editable_ = false;
+    int cursor_ = 0;
+    std::vector<Cell> cells_;
+
+    QRect cellRect(int index) const;
+    int cellAt(const QPoint &point) const;
+    void activate(int index, const QPoint &menuPosition);
+    void moveCursor(int dx, int dy);
+    void updateCell(int index);
+};
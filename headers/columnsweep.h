@@ -0,0 +1,60 @@
+#pragma once
+#include "frontier.h"
+#include "problemparameters.h"
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Exact frontier solver that sweeps the board slice by slice along its long
+// axis. A state holds the bad assignment of the frontier holes in the last
+// two slices, which is all a constraint closing in the next slice can see,
+// together with a weight for every bad count used so far. The cost is linear
+// in board length and exponential only in the slice length.
+class ColumnSweep
+{
+public:
+    static constexpr int maxSliceLength = 8;
+
+    explicit ColumnSweep(const ProblemParameters &params);
+
+    static bool isSuitable(const ProblemParameters &params);
+
+    void solve(const FrontierProblem &problem, FrontierSolution &solution);
+
+private:
+    struct Transition {
+        int from;
+        int to;
+        int bad;
+    };
+
+    struct Layer {
+        std::unordered_map<uint64_t, int> states;
+        std::vector<uint64_t> keys;
+        std::vector<std::vector<double>> forward;
+        std::vector<std::vector<double>> backward;
+        std::vector<Transition> transitions;
+    };
+
+    // Hole masks of a constraint in the two slices before its closing slice
+    // and in the closing slice itself.
+    struct SliceConstraint {
+        int maxBadness;
+        std::array<uint32_t, 3> masks;
+    };
+
+    int width_;
+    bool alongX_;
+    int sliceCount_;
+    std::vector<std::vector<int>> sliceHoles_;
+    std::vector<std::vector<SliceConstraint>> closingConstraints_;
+    std::vector<Layer> layers_;
+    std::vector<int> holeSlice_;
+    std::vector<int> holeBit_;
+    std::vector<double> completions_;
+
+    bool buildSlices(const FrontierProblem &problem);
+    void sweepForward(int badSpots);
+    void sweepBackward();
+};
@@ -1,7 +1,51 @@
 #pragma once
+#include <array>
 #include <vector>
 
 struct Constraint {
     int maxBadness = 0;
+    int badness = 0;
+    int listPosition = -1;
     std::vector<int> holes;
+    // The neighbor slot of every hole, and for every neighbor slot the
+    // position of its hole in `holes` (-1 when it holds none), so that holes
+    // are found and removed in constant time.
+    std::vector<int> holeSlots;
+    std::array<int, 8> slotPositions = {-1, -1, -1, -1, -1, -1, -1, -1};
+
+    bool hasHoleAt(int slot) const { return slotPositions[slot] != -1; }
+
+    void addHole(int hole, int slot)
+    {
+        slotPositions[slot] = int(holes.size());
+        holes.push_back(hole);
+        holeSlots.push_back(slot);
+    }
+
+    void removeHoleAt(int slot)
+    {
+        const int position = slotPositions[slot];
+        slotPositions[holeSlots.back()] = position;
+        holes[position] = holes.back();
+        holeSlots[position] = holeSlots.back();
+        slotPositions[slot] = -1;
+        holes.pop_back();
+        holeSlots.pop_back();
+    }
+
+    int popHole()
+    {
+        const int hole = holes.back();
+        slotPositions[holeSlots.back()] = -1;
+        holes.pop_back();
+        holeSlots.pop_back();
+        return hole;
+    }
+
+    void clearHoles()
+    {
+        holes.clear();
+        holeSlots.clear();
+        slotPositions.fill(-1);
+    }
 };
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Input of the exact probability engines: the constrained unopened holes,
+// and for every active constraint the positions of its holes in `holes`.
+// A constraint with maxBadness m is satisfied by m - 1 or m bad holes.
+struct FrontierProblem {
+    std::vector<int> holes;
+    std::vector<std::vector<int>> constraintHoles;
+    std::vector<int> maxBadness;
+    int unconstrainedHoles = 0;
+    int badSpots = 0;
+};
+
+// The values a hole takes across the layouts counted, as a bit set. A hole
+// with neither is in no layout at all.
+namespace Outcomes
+{
+
+enum : uint8_t { safe = 1, bad = 2 };
+
+// The outcomes of the holes of a group of `holes` when `badCount` of them
+// are bad.
+inline uint8_t ofCount(int badCount, int holes)
+{
+    return uint8_t((badCount > 0 ? bad : 0) | (badCount < holes ? safe : 0));
+}
+
+} // namespace Outcomes
+
+// Output of the exact probability engines. Weights count board layouts:
+// badWeight[i] is the number of layouts in which holes[i] is bad, and
+// unconstrainedBadWeight the same for each unconstrained hole. Counts too
+// large for a double are divided by exp(logScale). The outcomes are found
+// from which bad counts some layout allows rather than from the weights, so
+// a hole is certain only if no layout at all has it the other way.
+struct FrontierSolution {
+    std::vector<double> badWeight;
+    std::vector<uint8_t> outcomes;
+    double unconstrainedBadWeight = 0.0;
+    uint8_t unconstrainedOutcomes = 0;
+    double totalWeight = 0.0;
+    double logScale = 0.0;
+    uint64_t iterations = 0;
+    int legalIterations = 0;
+    int partitions = 0;
+};
+
+// Fills completions[c] with the number of ways to place the badSpots - c
+// bad spots not used by the frontier among the unconstrained holes, for c
+// from 0 to badSpots. Returns the logScale the values are divided by.
+// A possible completion stays above zero however far it is scaled down, so
+// that a weight built from whole counts and completions is zero only when no
+// layout is possible.
+double buildCompletions(int unconstrainedHoles,
+                        int badSpots,
+                        std::vector<double> &completions);
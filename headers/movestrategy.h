@@ -0,0 +1,72 @@
+#pragma once
+#include "dugtype.h"
+#include "problemparameters.h"
+#include <memory>
+#include <vector>
+
+class RolloutEvaluator;
+
+struct MoveContext {
+    const ProblemParameters &params;
+    const std::vector<double> &probabilities;
+    const std::vector<double> &neighborSums;
+    const std::vector<DugType::DugType> &knownBoard;
+};
+
+class MoveStrategy
+{
+public:
+    virtual ~MoveStrategy() = default;
+
+    virtual const char *name() const = 0;
+    // Returns the index of the cell to dig, or -1 if no cell is undug.
+    virtual int selectMove(const MoveContext &context) const = 0;
+};
+
+class LowestRiskStrategy : public MoveStrategy
+{
+public:
+    const char *name() const override;
+    int selectMove(const MoveContext &context) const override;
+};
+
+class RiskNeighborSumStrategy : public MoveStrategy
+{
+public:
+    const char *name() const override;
+    int selectMove(const MoveContext &context) const override;
+};
+
+class ExpectedRupeeStrategy : public MoveStrategy
+{
+public:
+    const char *name() const override;
+    int selectMove(const MoveContext &context) const override;
+};
+
+class InformationGainStrategy : public MoveStrategy
+{
+public:
+    const char *name() const override;
+    int selectMove(const MoveContext &context) const override;
+};
+
+// Digs a known safe cell when there is one, and otherwise the cell whose
+// Monte Carlo rollouts win most often.
+class RolloutStrategy : public MoveStrategy
+{
+public:
+    explicit RolloutStrategy(const ProblemParameters &params);
+    ~RolloutStrategy() override;
+
+    const char *name() const override;
+    int selectMove(const MoveContext &context) const override;
+
+private:
+    std::unique_ptr<RolloutEvaluator> evaluator_;
+};
+
+// Every strategy above; the rollout strategy costs a time budget per move,
+// so it is only included on request.
+std::vector<std::unique_ptr<MoveStrategy>>
+createMoveStrategies(const ProblemParameters &params, bool withRollouts);
@@ -0,0 +1,25 @@
+#pragma once
+#include "problemparameters.h"
+#include <vector>
+
+// Computes the summed bad probability of the 3x3 neighbors of every cell in
+// one separable stencil pass (a horizontal then a vertical box sum).
+class NeighborSumKernel
+{
+public:
+    explicit NeighborSumKernel(const ProblemParameters &params);
+
+    void compute(const std::vector<double> &probabilities);
+
+    const std::vector<double> &sums() const;
+
+private:
+    int width_;
+    int height_;
+    std::vector<double> rowSums_;
+    std::vector<double> sums_;
+
+    void boxSum(const std::vector<double> &values,
+                std::vector<double> &rowSums,
+                std::vector<double> &sums);
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+// Compressed list of the in-bounds 3x3 neighbors of every cell. Tables are
+// immutable and shared between everything working on the same board shape.
+// For the k-th neighbor n of a cell, reverseSlots(cell)[k] is the position
+// of the cell in n's own neighbor list.
+class NeighborTable
+{
+public:
+    struct Range {
+        const int *first;
+        const int *last;
+
+        const int *begin() const { return first; }
+        const int *end() const { return last; }
+        int size() const { return int(last - first); }
+    };
+
+    NeighborTable(int width, int height);
+
+    static std::shared_ptr<const NeighborTable> forShape(int width,
+                                                         int height);
+
+    Range operator[](int index) const
+    {
+        return {indices_.data() + offsets_[index],
+                indices_.data() + offsets_[index + 1]};
+    }
+
+    const int *reverseSlots(int index) const
+    {
+        return reverseSlots_.data() + offsets_[index];
+    }
+
+private:
+    std::vector<int> offsets_;
+    std::vector<int> indices_;
+    std::vector<int> reverseSlots_;
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include "dugtype.h"
+#include "problemparameters.h"
+#include "transpositioncache.h"
+#include <QString>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Solved positions of the opening phase on preset board shapes: every
+// consistent position with up to `depth` dug cells, stored once per
+// symmetry class. Shared books are loaded, or generated and kept in the
+// user's cache directory, by their first lookup, which runs on the solver's
+// thread rather than the one asking for the book.
+class OpeningBook
+{
+public:
+    static constexpr int defaultDepth = 2;
+    // Bump whenever the solver's results or the file layout change.
+    static constexpr uint32_t version = 4;
+
+    OpeningBook(const ProblemParameters &params, int depth);
+
+    // The shared book for `params`, or nullptr when the shape has no preset.
+    // It is filled in by its first lookup.
+    static std::shared_ptr<const OpeningBook>
+    forParameters(const ProblemParameters &params);
+
+    static QString defaultPath(const ProblemParameters &params);
+
+    void generate();
+    bool load(const QString &path);
+    bool save(const QString &path) const;
+
+    // Zero for a shared book until its first lookup.
+    int size() const;
+    // Fills `position` with the stored probabilities, total weight and
+    // statistics of the solve that produced them.
+    bool find(const TranspositionCache::Key &key,
+              TranspositionCache::Position &position) const;
+
+private:
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint32_t bombs;
+        uint32_t rupoors;
+        uint32_t depth;
+        uint32_t count;
+    };
+
+    static constexpr uint32_t magic = 0x424f4454; // "TDOB"
+
+    ProblemParameters params_;
+    int numHoles_;
+    int depth_;
+    // Set for shared books, which load or generate their entries lazily.
+    QString path_;
+    mutable std::once_flag prepared_;
+    // Statistics of the solve of one entry, in the order of
+    // TranspositionCache::Position.
+    struct Statistics {
+        uint64_t iterations;
+        int32_t legalIterations;
+        int32_t partitions;
+        int32_t sunkenPartitions;
+        int32_t constrainedHoles;
+        int32_t deducedHoles;
+        int32_t padding;
+    };
+
+    // Entries sorted by hash; the i-th entry owns numHoles_ cells of
+    // boards_ and probabilities_.
+    std::vector<uint64_t> hashes_;
+    std::vector<double> totalWeights_;
+    std::vector<Statistics> statistics_;
+    std::vector<int8_t> boards_;
+    std::vector<float> probabilities_;
+
+    FileHeader header() const;
+    void prepare();
+};
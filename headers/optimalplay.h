@@ -0,0 +1,94 @@
+#pragma once
+#include "dugtype.h"
+#include "problemparameters.h"
+#include "solver.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Solves small boards exactly: the chance of clearing the board under
+// perfect play, found by depth-first search over revealed boards. A dig is
+// a chance node weighted by the Solver's probabilities, and every board is
+// searched once per symmetry class, its value kept in a table shared by the
+// threads that search the moves of the root.
+//
+// Known safe cells are dug before anything else, as doing so never lowers
+// the chance of winning, and moves that cannot beat the best one found are
+// cut off by their risk.
+class OptimalPlay
+{
+public:
+    // Boards of up to this many cells pack into one 64-bit key.
+    static constexpr int maxHoles = 21;
+
+    struct MoveValue {
+        int cell = -1;
+        double winProbability = 0.0;
+    };
+
+    // One thread per hardware thread when `threads` is not positive.
+    explicit OptimalPlay(const ProblemParameters &params, int threads = 0);
+
+    static bool isFeasible(const ProblemParameters &params);
+
+    // The win probability of perfect play from `position`, which holds one
+    // row-major entry per cell. Every undug cell that may be safe is valued
+    // as the next dig.
+    double solve(const std::vector<DugType::DugType> &position);
+    // The most valuable cell of the last solve, or -1 if none was valued.
+    int bestMove() const;
+    const std::vector<MoveValue> &moveValues() const;
+    size_t positions() const;
+
+private:
+    struct Outcome {
+        double weight = 0.0;
+        double winProbability = 0.0;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, Outcome> outcomes;
+    };
+
+    // The state of one searching thread; probabilities are kept per depth,
+    // as the solver is reused all the way down.
+    struct Search {
+        explicit Search(const ProblemParameters &params);
+
+        Solver solver;
+        std::vector<DugType::DugType> board;
+        std::vector<std::vector<double>> probabilities;
+    };
+
+    static constexpr int shardCount = 64;
+
+    ProblemParameters params_;
+    int numHoles_;
+    int threads_;
+    std::vector<std::vector<int>> symmetries_;
+    std::vector<int> neighborCounts_;
+    std::array<Shard, shardCount> shards_;
+    std::vector<MoveValue> moveValues_;
+    std::vector<MoveValue> rootMoves_;
+    std::atomic<int> nextMove_{0};
+
+    uint64_t canonicalKey(const std::vector<DugType::DugType> &board) const;
+    bool find(uint64_t key, Outcome &outcome);
+    void store(uint64_t key, const Outcome &outcome);
+
+    Outcome solveBoard(Search &search, int undug, int hiddenRupoors);
+    double moveValue(Search &search,
+                     int cell,
+                     double badProbability,
+                     int undug,
+                     int hiddenRupoors);
+    void searchRootMoves(Search &search,
+                         int undug,
+                         int hiddenRupoors,
+                         const std::vector<double> &probabilities);
+};
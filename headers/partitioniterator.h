@@ -1,28 +1,50 @@
 #pragma once
+#include "weightarithmetic.h"
 #include <vector>
 
+struct Constraint;
 struct Partition;
 
+// Enumerates the bad-spot counts of the partitions in a reflected Gray
+// order: consecutive configurations differ by one bad spot moved between two
+// partitions, so the weight and the constraint counts are updated in
+// constant time per step.
+//
+// Weights are kept in the arithmetic of the Weight policy, one of those in
+// weightarithmetic.h.
+template <typename Weight>
 class PartitionIterator
 {
 public:
+    using WeightValue = typename Weight::Value;
+
     PartitionIterator(std::vector<Partition *> *partitionList,
                       std::vector<bool> &badspots,
                       std::vector<Partition *> *sunkenPartitions,
+                      const std::vector<Constraint *> &constraintList,
                       int numBadSpots);
 
     bool hasNext();
-    double iterate();
+    const WeightValue &iterate() const;
+    bool isLegal() const;
 
 private:
-    double choose(int n, int k);
+    int lowestOffset(int level) const;
+    int highestOffset(int level) const;
+    int offset(int level) const;
+    void moveBadSpot(int level, int direction);
+    void resetBelow(int level);
+
     std::vector<Partition *> &partitionList;
-    double weight;
-    std::vector<int> indexArray;
-    int indexArrayLength;
+    WeightValue weight;
     int listLength;
-    bool started;
+    bool feasible;
+    int unsatisfiedConstraints;
     std::vector<int> maxAmountsPerPartition;
     std::vector<int> minAmountsPerPartition;
+    std::vector<int> capacityBelow;
+    std::vector<int> remaining;
+    std::vector<bool> reversed;
+    std::vector<std::vector<Constraint *>> partitionConstraints;
     std::vector<bool> &badSpots;
 };
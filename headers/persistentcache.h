@@ -0,0 +1,67 @@
+#pragma once
+#include "problemparameters.h"
+#include "transpositioncache.h"
+#include <QFile>
+#include <QString>
+#include <cstdint>
+
+// Optional file-backed cache of solved positions that outlives the process.
+// The file is a memory-mapped open-addressing table of fixed-size slots keyed
+// by canonical position hash, holding 16-bit quantised probabilities and the
+// statistics of the solve that produced them. Nothing is locked: every slot
+// carries a checksum, so a slot torn by a concurrent writer, in this or
+// another process, reads as a miss. Files written for other parameters,
+// another table size or another version are replaced. The file is only
+// created by the first insert, and creating one drops the least recently
+// written cache files of other parameter sets beyond totalSizeCap.
+class PersistentCache
+{
+public:
+    // Bump whenever the solver's results or the file layout change.
+    static constexpr uint32_t version = 3;
+    static constexpr qint64 defaultSizeCap = qint64(64) << 20;
+    static constexpr qint64 totalSizeCap = qint64(256) << 20;
+
+    PersistentCache(const QString &path,
+                    const ProblemParameters &params,
+                    qint64 sizeCap = defaultSizeCap);
+
+    // A file per parameter set in the user's cache directory.
+    static QString defaultPath(const ProblemParameters &params);
+
+    bool isOpen() const;
+
+    // Fills `position` with quantised probabilities; everything else is
+    // returned as stored.
+    bool find(const TranspositionCache::Key &key,
+              TranspositionCache::Position &position) const;
+    void insert(const TranspositionCache::Key &key,
+                const TranspositionCache::Position &position);
+
+private:
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint32_t bombs;
+        uint32_t rupoors;
+        uint32_t slotCount;
+        uint32_t slotSize;
+    };
+
+    static constexpr uint32_t magic = 0x43504454; // "TDPC"
+    static constexpr int maxProbes = 8;
+
+    QFile file_;
+    uchar *data_ = nullptr;
+    bool writable_ = false;
+    bool creationTried_ = false;
+    int numHoles_;
+    FileHeader header_;
+
+    bool mapFile(QIODevice::OpenMode mode);
+    bool createFile();
+    uchar *slot(uint64_t index) const;
+    uint64_t checksum(const uchar *slot) const;
+};
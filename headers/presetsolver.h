@@ -0,0 +1,223 @@
+#pragma once
+#include "frontier.h"
+#include "problemparameters.h"
+#include <algorithm>
+#include <array>
+#include <bitset>
+
+// Exact frontier solver for a fixed board shape. All working storage is
+// sized at compile time, holes are grouped into partitions by comparing
+// fixed-size constraint masks, and the partition badness vectors are
+// enumerated depth first with per-constraint bounds, so every leaf reached
+// is a legal configuration.
+template <int Width, int Height>
+class PresetSolver
+{
+public:
+    static constexpr int numHoles = Width * Height;
+
+    void solve(const FrontierProblem &problem, FrontierSolution &solution);
+
+private:
+    static constexpr int maxConstraintsPerHole = 8;
+    using ConstraintMask = std::bitset<numHoles>;
+
+    struct Binomials {
+        constexpr Binomials() : table()
+        {
+            for (int n = 0; n <= numHoles; n++) {
+                table[n][0] = 1.0;
+                for (int k = 1; k <= n; k++) {
+                    table[n][k] = table[n - 1][k - 1] + table[n - 1][k];
+                }
+            }
+        }
+        double table[numHoles + 1][numHoles + 1];
+    };
+    static constexpr Binomials binomials{};
+
+    int numPartitions = 0;
+    int unconstrainedHoles = 0;
+    int badSpots = 0;
+    std::array<ConstraintMask, numHoles> holeMasks{};
+    std::array<int, numHoles> holeOrder{};
+    std::array<int, numHoles> partitionOfHole{};
+    std::array<ConstraintMask, numHoles> partitionMasks{};
+    std::array<int, numHoles> partitionSize{};
+    std::array<int, numHoles> partitionConstraintCount{};
+    std::array<std::array<int, maxConstraintsPerHole>, numHoles>
+        partitionConstraints{};
+    std::array<int, numHoles + 1> remainingHoles{};
+    std::array<int, numHoles> badness{};
+    std::array<int, numHoles> lowerBound{};
+    std::array<int, numHoles> upperBound{};
+    std::array<int, numHoles> badCount{};
+    std::array<int, numHoles> openHoles{};
+    std::array<double, numHoles> partitionBadWeight{};
+    std::array<uint8_t, numHoles> partitionOutcomes{};
+    double unconstrainedBadWeight = 0.0;
+    uint8_t unconstrainedOutcomes = 0;
+    double totalWeight = 0.0;
+    uint64_t iterations = 0;
+
+    void search(int partition, int badSoFar, double weight);
+};
+
+template <int Width, int Height>
+void PresetSolver<Width, Height>::solve(const FrontierProblem &problem,
+                                        FrontierSolution &solution)
+{
+    const int numFrontier = int(problem.holes.size());
+    const int numConstraints = int(problem.constraintHoles.size());
+    badSpots = problem.badSpots;
+    unconstrainedHoles = problem.unconstrainedHoles;
+
+    for (int i = 0; i < numFrontier; i++) {
+        holeMasks[i].reset();
+        holeOrder[i] = i;
+    }
+    for (int c = 0; c < numConstraints; c++) {
+        for (int position : problem.constraintHoles[c]) {
+            holeMasks[position].set(c);
+        }
+        upperBound[c] = problem.maxBadness[c];
+        lowerBound[c] = std::max(problem.maxBadness[c] - 1, 0);
+        badCount[c] = 0;
+        openHoles[c] = int(problem.constraintHoles[c].size());
+    }
+    std::sort(holeOrder.begin(),
+              holeOrder.begin() + numFrontier,
+              [&](int a, int b) {
+                  return problem.holes[a] < problem.holes[b];
+              });
+
+    numPartitions = 0;
+    for (int i = 0; i < numFrontier; i++) {
+        const int hole = holeOrder[i];
+        if (holeMasks[hole].none()) {
+            partitionOfHole[hole] = -1;
+            unconstrainedHoles++;
+            continue;
+        }
+        int partition = 0;
+        while (partition < numPartitions &&
+               partitionMasks[partition] != holeMasks[hole]) {
+            partition++;
+        }
+        if (partition == numPartitions) {
+            partitionMasks[partition] = holeMasks[hole];
+            partitionSize[partition] = 0;
+            int &count = partitionConstraintCount[partition];
+            count = 0;
+            for (int c = 0; c < numConstraints; c++) {
+                if (holeMasks[hole].test(c)) {
+                    partitionConstraints[partition][count++] = c;
+                }
+            }
+            numPartitions++;
+        }
+        partitionSize[partition]++;
+        partitionOfHole[hole] = partition;
+    }
+    remainingHoles[numPartitions] = 0;
+    for (int p = numPartitions - 1; p >= 0; p--) {
+        remainingHoles[p] = remainingHoles[p + 1] + partitionSize[p];
+        partitionBadWeight[p] = 0.0;
+        partitionOutcomes[p] = 0;
+    }
+
+    unconstrainedBadWeight = 0.0;
+    unconstrainedOutcomes = 0;
+    totalWeight = 0.0;
+    iterations = 0;
+    bool satisfiable = true;
+    for (int c = 0; c < numConstraints; c++) {
+        if (openHoles[c] < lowerBound[c] || upperBound[c] < 0) {
+            satisfiable = false;
+        }
+    }
+    if (satisfiable) {
+        search(0, 0, 1.0);
+    }
+
+    solution.badWeight.resize(numFrontier);
+    solution.outcomes.resize(numFrontier);
+    const double perUnconstrainedHole =
+        unconstrainedHoles > 0 ? unconstrainedBadWeight / unconstrainedHoles
+                               : 0.0;
+    for (int i = 0; i < numFrontier; i++) {
+        const int partition = partitionOfHole[i];
+        if (partition == -1) {
+            solution.badWeight[i] = perUnconstrainedHole;
+            solution.outcomes[i] = unconstrainedOutcomes;
+        } else {
+            solution.badWeight[i] =
+                partitionBadWeight[partition] / partitionSize[partition];
+            solution.outcomes[i] = partitionOutcomes[partition];
+        }
+    }
+    solution.unconstrainedBadWeight = perUnconstrainedHole;
+    solution.unconstrainedOutcomes = unconstrainedOutcomes;
+    solution.totalWeight = totalWeight;
+    solution.logScale = 0.0;
+    solution.iterations = iterations;
+    solution.legalIterations = int(iterations);
+    solution.partitions = numPartitions + (unconstrainedHoles > 0 ? 1 : 0);
+}
+
+template <int Width, int Height>
+void PresetSolver<Width, Height>::search(int partition,
+                                         int badSoFar,
+                                         double weight)
+{
+    if (partition == numPartitions) {
+        const int rest = badSpots - badSoFar;
+        if (rest < 0 || rest > unconstrainedHoles) {
+            return;
+        }
+        iterations++;
+        const double w = weight * binomials.table[unconstrainedHoles][rest];
+        totalWeight += w;
+        unconstrainedBadWeight += w * rest;
+        unconstrainedOutcomes |= Outcomes::ofCount(rest, unconstrainedHoles);
+        for (int p = 0; p < numPartitions; p++) {
+            partitionBadWeight[p] += w * badness[p];
+            partitionOutcomes[p] |=
+                Outcomes::ofCount(badness[p], partitionSize[p]);
+        }
+        return;
+    }
+
+    const int size = partitionSize[partition];
+    const int numConstraints = partitionConstraintCount[partition];
+    const std::array<int, maxConstraintsPerHole> &constraints =
+        partitionConstraints[partition];
+    int low = std::max(0,
+                       badSpots - badSoFar - unconstrainedHoles -
+                           remainingHoles[partition + 1]);
+    int high = std::min(size, badSpots - badSoFar);
+    for (int i = 0; i < numConstraints; i++) {
+        const int c = constraints[i];
+        openHoles[c] -= size;
+        high = std::min(high, upperBound[c] - badCount[c]);
+        low = std::max(low, lowerBound[c] - badCount[c] - openHoles[c]);
+    }
+    for (int k = low; k <= high; k++) {
+        badness[partition] = k;
+        for (int i = 0; i < numConstraints; i++) {
+            badCount[constraints[i]] += k;
+        }
+        search(partition + 1, badSoFar + k, weight * binomials.table[size][k]);
+        for (int i = 0; i < numConstraints; i++) {
+            badCount[constraints[i]] -= k;
+        }
+    }
+    for (int i = 0; i < numConstraints; i++) {
+        openHoles[constraints[i]] += size;
+    }
+}
+
+bool hasPresetSolver(const ProblemParameters &params);
+void solvePreset(const ProblemParameters &params,
+                 const FrontierProblem &problem,
+                 FrontierSolution &solution);
@@ -0,0 +1,101 @@
+#pragma once
+#include "board.h"
+#include "boardsampler.h"
+#include "dugtype.h"
+#include "problemparameters.h"
+#include "solver.h"
+#include "transpositioncache.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+struct RolloutEstimate {
+    int cell = -1;
+    double probability = 0.0;
+    int rollouts = 0;
+    int wins = 0;
+    double rupees = 0.0;
+
+    double winProbability() const;
+    double expectedRupees() const;
+};
+
+// Estimates, for the safest few undug cells of a position, the chance of
+// clearing the board and the rupees held when the game ends if that cell is
+// dug next. Boards consistent with the position are drawn by a BoardSampler
+// and played out by the lowest-risk rule on a pool of worker threads, each
+// with its own Solver and Board. Every drawn board is played from each
+// candidate in turn, so that candidates are compared on the same boards.
+//
+// Sampling stops at the time budget, checked before each board, or after
+// the maximum number of boards. One evaluation runs at a time.
+class RolloutEvaluator
+{
+public:
+    // One worker per hardware thread when `threads` is not positive.
+    explicit RolloutEvaluator(const ProblemParameters &params, int threads = 0);
+    ~RolloutEvaluator();
+
+    void setTimeBudget(std::chrono::milliseconds budget);
+    void setMaxCandidates(int candidates);
+    void setMaxSamples(int samples);
+
+    // `position` holds one row-major entry per cell, and `rupees` the score
+    // so far. Estimates come in order of increasing risk; they are empty
+    // when no undug cell may be safe, and hold no rollouts when the position
+    // cannot be sampled.
+    const std::vector<RolloutEstimate> &
+    evaluate(const std::vector<DugType::DugType> &position, int rupees = 0);
+    // The cell of the last evaluation most likely to win, then the one with
+    // the most expected rupees, or -1 if there was no candidate.
+    int bestMove() const;
+
+private:
+    struct Worker {
+        Worker(const ProblemParameters &params, TranspositionCache *cache);
+
+        Solver solver;
+        Board board;
+        std::mt19937 rng;
+        std::vector<DugType::DugType> layout;
+        std::vector<DugType::DugType> known;
+        std::vector<RolloutEstimate> estimates;
+        std::thread thread;
+    };
+
+    ProblemParameters params_;
+    int numHoles_;
+    // Shared by the workers, so that rollouts do not crowd the positions of
+    // the interactive solvers out of the process-wide cache.
+    TranspositionCache cache_;
+    Solver solver_;
+    BoardSampler sampler_;
+    std::chrono::milliseconds budget_{100};
+    int maxCandidates_ = 8;
+    int maxSamples_ = 1 << 16;
+
+    // Read-only while a round runs.
+    std::vector<DugType::DugType> position_;
+    int rupees_ = 0;
+    std::vector<int> candidates_;
+    std::chrono::steady_clock::time_point deadline_;
+
+    std::vector<RolloutEstimate> estimates_;
+    std::atomic<int> nextSample_{0};
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable finished_;
+    uint64_t round_ = 0;
+    int running_ = 0;
+    bool stopping_ = false;
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    void work(Worker &worker);
+    void rollout(Worker &worker, RolloutEstimate &estimate);
+};
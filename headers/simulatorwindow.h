@@ -2,11 +2,9 @@
 
 #include "board.h"
 #include "ui_simulatorwindow.h"
-#include "vector2d.h"
 #include <QMainWindow>
 #include <memory>
 
-class QPushButton;
 class QCloseEvent;
 
 struct ProblemParameters;
@@ -30,11 +28,6 @@ signals:
 
 private:
     std::unique_ptr<Ui::SimulatorWindow> ui;
-    Vector2d<QPushButton *> cellGrid;
-    int boardWidth;
-    int boardHeight;
     int rupeeTotal;
     Board board;
-
-    void disableAllButtons();
 };
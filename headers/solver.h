@@ -1,20 +1,102 @@
 #pragma once
+#include "columnsweep.h"
 #include "constraint.h"
 #include "dugtype.h"
+#include "frontier.h"
 #include "partition.h"
 #include "problemparameters.h"
+#include "solversnapshot.h"
+#include "transpositioncache.h"
+#include "variableelimination.h"
+#include "vector2d.h"
 #include <QObject>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
 #include <unordered_set>
 #include <vector>
 
+class BoardDatabase;
+class NeighborTable;
+class OpeningBook;
+class PersistentCache;
+
 class Solver : public QObject
 {
     Q_OBJECT
 public:
-    Solver(const ProblemParameters &params);
+    enum class Engine {
+        automatic,
+        preset,
+        partitionEnumeration,
+        columnSweep,
+        variableElimination,
+        boardDatabase
+    };
+
+    // How the partition enumeration counts layouts: in doubles, as
+    // logarithms for boards whose counts overflow a double, or exactly in
+    // 128 bits. The automatic choice takes doubles unless they could
+    // overflow; the exact choice falls back to logarithms where counts
+    // could pass 2^128. Modes other than automatic bypass the caches and the
+    // opening book, so their results are their own.
+    enum class Arithmetic { automatic, floating, logarithmic, exact };
+
+    // How per-cell state is kept. Dense storage keeps a constraint and a
+    // probability for every cell. Sparse storage keeps them only for opened
+    // cells and the holes next to them, lets all unconstrained holes share
+    // one probability, and expands the full array only when
+    // getProbabilityArray asks for it. It does not consult the caches or the
+    // opening book, whose keys cover the whole board, and publishes no
+    // snapshots unless told to. The automatic choice is sparse above
+    // sparseHoles cells.
+    enum class Storage { automatic, dense, sparse };
+    static constexpr int sparseHoles = 1 << 16;
+
+    enum class HoleState : uint8_t {
+        unconstrained,
+        constrained,
+        knownSafe,
+        knownBad
+    };
 
+    Solver(const ProblemParameters &params,
+           Storage storage = Storage::automatic);
+
+    void setEngine(Engine engine);
+    // Solved positions are looked up in and stored to `cache`, for instance
+    // the process-wide TranspositionCache::shared(); none by default. A
+    // solver with a forced engine or arithmetic consults neither cache nor
+    // the opening book.
+    void setTranspositionCache(TranspositionCache *cache);
+    // Every solve writes a line of statistics to standard output, under a
+    // header written before the first, unless logging is turned off.
+    void setLogging(bool enabled);
+    // Every solve publishes a snapshot for other threads unless publishing
+    // is turned off; it is off by default in sparse storage.
+    void setPublishing(bool enabled);
+    void setArithmetic(Arithmetic arithmetic);
+    // An optional second level behind the transposition cache that keeps
+    // quantised results across runs.
+    void setPersistentCache(PersistentCache *cache);
+    // Positions in the book are answered before either cache is consulted.
+    void setOpeningBook(std::shared_ptr<const OpeningBook> book);
     void setCell(int x, int y, DugType::DugType type);
+    // Replaces the whole position at once; `types` holds one row-major entry
+    // per cell.
+    void loadBoard(const Vector2d<DugType::DugType> &board);
+    void loadBoard(const DugType::DugType *types);
     const std::vector<double> &getProbabilityArray() const;
+    // One cell's probability, without expanding the array.
+    double getProbability(int index);
+    // The result of the last completed solve; safe to call from any thread.
+    std::shared_ptr<const SolverSnapshot> snapshot() const;
+    // Counts board changes, so that a snapshot of an older board is told
+    // apart from one of the current board.
+    uint64_t getBoardGeneration() const;
+    bool isStale(const SolverSnapshot &snapshot) const;
     void reload();
 
     double getTotalNumConfigurations();
@@ -22,6 +104,16 @@ public:
     int getLegalIterations();
     int getConstrainedHoles();
     int getPartitions();
+    int getSunkenPartitions();
+    int getDeducedHoles();
+    uint64_t getCacheHits();
+    uint64_t getCacheLookups();
+
+    // The current position cell by cell, and its open constraints over the
+    // constrained holes, for consumers that need more than probabilities.
+    DugType::DugType getCellType(int index);
+    HoleState getHoleState(int index);
+    const FrontierProblem &getFrontierProblem();
 
 signals:
     void done();
@@ -30,11 +122,35 @@ public slots:
     void partitionCalculate();
 
 private:
+    // Per-cell state is stamped with the epoch it was written in. A record
+    // from an earlier epoch reads as an undug, unconstrained cell and is
+    // cleared when next touched, so starting a new game only bumps the epoch.
+    struct CellRecord {
+        uint32_t epoch = 0;
+        HoleState state = HoleState::unconstrained;
+        DugType::DugType type = DugType::DugType::undug;
+        // The cell's entry in `details` under sparse storage, or -1.
+        int detail = -1;
+    };
+
+    // What sparse storage keeps of an opened cell or a hole next to one.
+    // Entries are handed out in order and reused from the next epoch on.
+    struct CellDetail {
+        Constraint constraint;
+        std::unordered_set<Constraint *> imposingConstraints;
+        double probability = 0.0;
+        int frontierPosition = -1;
+    };
+
     inline static const std::unordered_set<Constraint *> emptySet;
     ProblemParameters params_;
     int numHoles = 0;
-    int bombsAmongConstrainedHoles = 0;
-    std::vector<double> probabilities;
+    bool sparse = false;
+    std::shared_ptr<const NeighborTable> neighbors;
+    // Under sparse storage, an expansion rebuilt when asked for after a
+    // change.
+    mutable std::vector<double> probabilities;
+    mutable bool probabilitiesExpanded = false;
     std::vector<Constraint *> constraintList;
     std::vector<Constraint> constraints;
 
@@ -42,22 +158,100 @@ private:
     std::vector<bool> badSpots;
 
     std::vector<std::unordered_set<Constraint *>> imposingConstraints;
-    std::unordered_set<int> constrainedUnopenedHoles;
-    std::unordered_set<int> unconstrainedUnopenedHoles;
-    std::unordered_set<int> knownSafeSpots;
-    std::unordered_set<int> knownBadSpots;
+    std::vector<CellRecord> cells;
+    std::deque<CellDetail> details;
+    size_t usedDetails = 0;
+    // Sparse storage: the constrained holes, the probability shared by the
+    // unconstrained ones, and the cells changed since the last consistency
+    // check.
+    std::vector<int> frontier;
+    double unconstrainedProbability = 0.0;
+    // What the engine found each unknown hole can turn out to be, as
+    // Outcomes; the unconstrained holes share theirs under sparse storage.
+    std::vector<uint8_t> outcomes;
+    uint8_t unconstrainedOutcomes = 0;
+    std::vector<int> changedCells;
+    bool contradiction = false;
+    uint32_t epoch = 1;
+    std::array<int, 4> stateCounts = {};
     std::vector<Partition *> partitionList;
     std::vector<Partition *> sunkenPartitions;
+    std::vector<double> partitionBadWeight;
+    std::vector<uint8_t> partitionOutcomes;
 
-    std::vector<DugType::DugType> board;
     double totalWeight = 0.0;
     uint64_t totalIterations = 0;
     int legalIterations = 0;
     int numConstrained = 0;
+    int numPartitions = 0;
+    int numSunkenPartitions = 0;
+    int deducedHoles = 0;
+    double weightLogScale = 0.0;
+    Engine engine = Engine::automatic;
+    bool logging = true;
+    bool headerLogged = false;
+    bool publishing = true;
+    Arithmetic arithmetic = Arithmetic::automatic;
+    ColumnSweep columnSweep;
+    VariableElimination variableElimination;
+    std::shared_ptr<const BoardDatabase> boardDatabase;
+    std::vector<DugType::DugType> databaseBoard;
+    std::vector<double> databaseWeights;
+    std::vector<uint64_t> databaseScratch;
+    FrontierProblem frontierProblem;
+    FrontierSolution frontierSolution;
+    TranspositionCache *transpositionCache = nullptr;
+    PersistentCache *persistentCache = nullptr;
+    std::shared_ptr<const OpeningBook> openingBook;
+    std::vector<std::vector<int>> symmetries;
+    std::vector<DugType::DugType> cacheBoard;
+    TranspositionCache::Key cacheKey;
+    TranspositionCache::Position cachedPosition;
+    uint64_t cacheHits = 0;
+    uint64_t cacheLookups = 0;
+    std::atomic<uint64_t> boardGeneration{0};
+    std::shared_ptr<const SolverSnapshot> publishedSnapshot;
 
-    bool validateBoard();
+    CellRecord &cell(int index);
+    CellDetail &detail(int index);
+    Constraint &constraintAt(int index);
+    std::unordered_set<Constraint *> &imposingConstraintsOf(int hole);
+    double probability(int index);
+    void setProbability(int index, double value);
+    uint8_t holeOutcomes(int index);
+    void addOutcomes(int index, uint8_t values);
+    void addPartitionWeight(const Partition *partition,
+                            double weight,
+                            uint8_t values);
+    void expandProbabilities() const;
+    bool isUnknown(int index);
+    void setHoleState(int index, HoleState state);
+    int countHoles(HoleState state) const;
+    void collectHoles(HoleState state, std::vector<int> &holes);
+    void startEpoch();
+    bool findPosition();
+    void solvePosition();
+    bool isConsistent();
+    bool isCellConsistent(int index);
+    void normalizeFrontier();
+    void storePosition(int symmetry);
+    void applyCachedPosition(int symmetry);
+    void publishSnapshot(bool cached);
+    int deduce();
+    void removeDuplicateConstraints();
+    Engine activeEngine() const;
+    void applyFrontierSolution();
+    void enumeratePartitions();
+    Arithmetic activeArithmetic() const;
+    template <typename Weight>
+    void enumerateWith();
+    void lookUpDatabase();
+    void buildFrontierProblem();
     void setKnownSafeSpot(int index);
     void setKnownBadSpot(int index);
+    void activateConstraint(Constraint *constraint);
+    void deactivateConstraint(Constraint *constraint);
+    void settleConstraint(Constraint *constraint);
     void resetBoard();
     void generatePartitions();
     double choose(unsigned long long n, unsigned long long k);
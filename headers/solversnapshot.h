@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// A completed solver result. Snapshots are never modified once published,
+// so readers on any thread see either the previous result or the next one,
+// never a solve in progress.
+struct SolverSnapshot {
+    // The solver's board generation this result was computed for.
+    uint64_t generation = 0;
+    std::vector<double> probabilities;
+    // Undug cells sharing the lowest probability.
+    std::vector<int> lowestRisk;
+    double totalConfigurations = 0.0;
+    uint64_t iterations = 0;
+    int legalIterations = 0;
+    int partitions = 0;
+    int constrainedHoles = 0;
+    int deducedHoles = 0;
+    bool cacheHit = false;
+};
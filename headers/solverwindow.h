@@ -1,18 +1,13 @@
 #pragma once
 
-#include "solver.h"
+#include "dugtype.h"
+#include "solversnapshot.h"
+#include "solverworker.h"
 #include "ui_solverwindow.h"
-#include "vector2d.h"
 #include <QMainWindow>
+#include <memory>
 #include <qmovie.h>
-#include <qthread.h>
 
-namespace DugType
-{
-enum DugType : int;
-}
-
-class QVBoxLayout;
 class QCloseEvent;
 
 struct ProblemParameters;
@@ -23,27 +18,25 @@ class SolverWindow : public QMainWindow
 
 public:
     explicit SolverWindow(const ProblemParameters &params,
+                          bool keepPositions = false,
                           QWidget *parent = nullptr);
     void closeEvent(QCloseEvent *e);
 
 private slots:
     void on_calculateButton_clicked();
-    void processCalculation();
-    void cellSet(int x, int y);
+    void processCalculation(quint64 solvedGeneration);
+    void cellSet(int x, int y, DugType::DugType type);
     void cellOpened(int x, int y, DugType::DugType type);
 
 signals:
     void closing();
+    void cellChanged(int x, int y, int type, quint64 generation);
+    void solveRequested(quint64 generation);
 
 private:
     std::unique_ptr<Ui::SolverWindow> ui;
-    Vector2d<QVBoxLayout *> cellGrid;
     std::unique_ptr<QMovie> movie;
-    Vector2d<DugType::DugType> boardState;
-    Solver solver;
-    std::unique_ptr<QThread> thread;
-    const std::vector<double> &probabilityArray;
-    int boardWidth;
-    int boardHeight;
-    int numHoles;
+    std::unique_ptr<SolverWorker> worker;
+    std::shared_ptr<const SolverSnapshot> shown;
+    quint64 generation = 0;
 };
@@ -0,0 +1,50 @@
+#pragma once
+#include "dugtype.h"
+#include "persistentcache.h"
+#include "problemparameters.h"
+#include "solver.h"
+#include "solversnapshot.h"
+#include <QObject>
+#include <QThread>
+#include <memory>
+#include <vector>
+
+// Owns a Solver on its own thread for the lifetime of a window. Board edits
+// arrive as queued calls and only update the pending board; a solve is queued
+// behind them, so edits that arrive faster than solves finish fold into one
+// solve of the newest board. Every result carries the generation of the last
+// edit it includes; the result itself is read through snapshot(), so that it
+// is shared with the window rather than copied into the event queue.
+class SolverWorker : public QObject
+{
+    Q_OBJECT
+public:
+    // With keepPositions, solved positions are also kept on disk for later
+    // sessions.
+    SolverWorker(const ProblemParameters &params, bool keepPositions);
+    ~SolverWorker() override;
+
+    // The newest published result; safe to call from any thread.
+    std::shared_ptr<const SolverSnapshot> snapshot() const;
+
+public slots:
+    void setCell(int x, int y, int type, quint64 generation);
+    void requestSolve(quint64 generation);
+
+signals:
+    void solved(quint64 generation);
+
+private slots:
+    void solvePending();
+
+private:
+    ProblemParameters params_;
+    std::unique_ptr<PersistentCache> persistentCache_;
+    Solver solver_;
+    std::vector<DugType::DugType> board_;
+    quint64 generation_ = 0;
+    bool scheduled_ = false;
+    QThread thread_;
+
+    void schedule();
+};
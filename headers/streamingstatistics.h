@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Constant-memory running statistics: count, mean and variance (Welford) plus
+// a fixed-bucket histogram over [lower, upper) used as a mergeable quantile
+// sketch. Values outside the range are clamped into the edge buckets.
+class StreamingStatistics
+{
+public:
+    StreamingStatistics(double lower, double upper, int buckets);
+
+    void add(double value);
+    void merge(const StreamingStatistics &other);
+
+    uint64_t count() const;
+    double mean() const;
+    double variance() const;
+    double quantile(double q) const;
+
+private:
+    double lower_;
+    double upper_;
+    uint64_t count_ = 0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;
+    std::vector<uint64_t> histogram_;
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include "dugtype.h"
+#include "problemparameters.h"
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Bounded, thread-safe LRU cache of solved positions, shared by the solvers
+// it is handed to. Positions are stored in a canonical orientation: of all
+// symmetries of the board, the one giving the smallest Zobrist hash.
+class TranspositionCache
+{
+public:
+    struct Key {
+        uint64_t hash = 0;
+        int width = 0;
+        int height = 0;
+        int bombs = 0;
+        int rupoors = 0;
+        std::vector<DugType::DugType> board;
+
+        bool operator==(const Key &other) const;
+    };
+
+    // Everything partitionCalculate reports for a position, with the
+    // probabilities in canonical orientation.
+    struct Position {
+        std::vector<double> probabilities;
+        double totalWeight = 0.0;
+        double logScale = 0.0;
+        uint64_t iterations = 0;
+        int legalIterations = 0;
+        int partitions = 0;
+        int sunkenPartitions = 0;
+        int constrainedHoles = 0;
+        int deducedHoles = 0;
+    };
+
+    static constexpr size_t defaultCapacity = 1 << 12;
+
+    explicit TranspositionCache(size_t capacity = defaultCapacity);
+
+    // One cache for the whole process, for solvers that opt into it.
+    static TranspositionCache &shared();
+
+    // Cell permutations of the board's symmetry group, identity first: the
+    // four mirrorings, plus the four transposed ones for square boards.
+    static std::vector<std::vector<int>> symmetries(int width, int height);
+
+    // Fills `key` with the canonical form of the row-major `types` and
+    // returns the index of the symmetry that maps the board onto it.
+    static int makeKey(const ProblemParameters &params,
+                       const std::vector<std::vector<int>> &symmetries,
+                       const std::vector<DugType::DugType> &types,
+                       Key &key);
+
+    bool find(const Key &key, Position &position);
+    void insert(const Key &key, const Position &position);
+
+    uint64_t hits() const;
+    uint64_t lookups() const;
+
+private:
+    struct Entry {
+        Key key;
+        Position position;
+    };
+
+    size_t capacity_;
+    std::list<Entry> entries_;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+    uint64_t hits_ = 0;
+    uint64_t lookups_ = 0;
+    mutable std::mutex mutex_;
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include "frontier.h"
+#include <set>
+#include <vector>
+
+// Exact frontier solver for irregular boards. Holes are grouped into
+// partitions by constraint membership, every constraint becomes a factor
+// over the bad counts of its partitions, and partitions are summed out one
+// by one in a min-fill order. Factor entries are polynomials over the number
+// of bad spots already summed out, so the global bad count is respected. A
+// backward sweep over the same buckets then yields every marginal at once.
+// The cost is exponential in the width of the elimination order only.
+class VariableElimination
+{
+public:
+    static constexpr int maxFactorEntries = 1 << 20;
+
+    // Returns false, leaving the solution untouched, when the elimination
+    // order would need a factor larger than maxFactorEntries.
+    bool solve(const FrontierProblem &problem, FrontierSolution &solution);
+
+private:
+    struct Factor {
+        std::vector<int> scope;
+        std::vector<std::vector<double>> table;
+    };
+
+    int badSpots_ = 0;
+    int numPartitions_ = 0;
+    std::vector<int> partitionOfHole_;
+    std::vector<int> partitionSize_;
+    std::vector<std::set<int>> adjacent_;
+    std::vector<Factor> constraintFactors_;
+    std::vector<int> order_;
+    // Per partition: the factors multiplied in its bucket, the partition
+    // whose message each of them is (-1 for a constraint), and the message
+    // passed down to it from the rest of the elimination tree.
+    std::vector<std::vector<Factor>> buckets_;
+    std::vector<std::vector<int>> bucketSources_;
+    std::vector<Factor> downward_;
+    std::vector<int> values_;
+    std::vector<double> completions_;
+    uint64_t entries_ = 0;
+
+    bool buildFactors(const FrontierProblem &problem);
+    bool chooseOrder();
+    std::vector<double> eliminate();
+    void distribute(std::vector<double> &partitionBadWeight,
+                    std::vector<uint8_t> &partitionOutcomes);
+    int entryIndex(const Factor &factor) const;
+    void multiply(std::vector<double> &product,
+                  const std::vector<double> &factor) const;
+};
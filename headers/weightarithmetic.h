@@ -0,0 +1,192 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// Arithmetic on the weights of the partition enumeration, which count board
+// layouts as products of binomial coefficients. The enumeration is written
+// once against these policies: a weight is only ever scaled by a ratio of
+// small integers that leaves it a whole count, summed, and finally read out
+// divided by exp(logScale(total)). Whether a weight is zero is decided on the
+// Value itself, before any conversion, in every policy.
+
+// Plain doubles: the fastest, exact up to 2^53 layouts, and overflowing past
+// about 1e308.
+struct DoubleWeight {
+    using Value = double;
+
+    static Value zero() { return 0.0; }
+    static Value one() { return 1.0; }
+
+    static void multiply(Value &weight, int numerator, int denominator)
+    {
+        weight *= double(numerator) / denominator;
+    }
+
+    static void multiplyBinomial(Value &weight, int n, int k)
+    {
+        if (k > n) {
+            weight = 0.0;
+            return;
+        }
+        double r = 1.0;
+        for (int d = 1; d <= k; ++d) {
+            r *= n--;
+            r /= d;
+        }
+        weight *= r;
+    }
+
+    static void add(Value &sum, const Value &weight) { sum += weight; }
+
+    static void addMultiple(Value &sum, const Value &weight, int factor)
+    {
+        sum += weight * factor;
+    }
+
+    static bool isZero(const Value &weight) { return weight == 0.0; }
+    static double logScale(const Value &) { return 0.0; }
+    static double toDouble(const Value &weight, double) { return weight; }
+};
+
+// Natural logarithms of the weights, for boards whose layout counts do not
+// fit in a double. Sums cost a logarithm and an exponential each.
+struct LogWeight {
+    using Value = double;
+
+    static Value zero() { return -std::numeric_limits<double>::infinity(); }
+    static Value one() { return 0.0; }
+
+    static void multiply(Value &weight, int numerator, int denominator)
+    {
+        weight += std::log(double(numerator) / denominator);
+    }
+
+    static void multiplyBinomial(Value &weight, int n, int k)
+    {
+        if (k > n) {
+            weight = zero();
+            return;
+        }
+        weight += std::lgamma(n + 1.0) - std::lgamma(k + 1.0) -
+                  std::lgamma(n - k + 1.0);
+    }
+
+    static void add(Value &sum, const Value &weight)
+    {
+        if (weight == zero()) {
+            return;
+        }
+        if (sum == zero()) {
+            sum = weight;
+            return;
+        }
+        const double high = std::max(sum, weight);
+        const double low = std::min(sum, weight);
+        sum = high + std::log1p(std::exp(low - high));
+    }
+
+    static void addMultiple(Value &sum, const Value &weight, int factor)
+    {
+        if (factor > 0) {
+            add(sum, weight + std::log(double(factor)));
+        }
+    }
+
+    static bool isZero(const Value &weight) { return weight == zero(); }
+
+    static double logScale(const Value &total)
+    {
+        return total == zero() ? 0.0 : total;
+    }
+
+    static double toDouble(const Value &weight, double logScale)
+    {
+        return weight == zero() ? 0.0 : std::exp(weight - logScale);
+    }
+};
+
+// Exact counts in 128 bits, for checking the other two; layout counts must
+// stay below 2^128. Every scaling divides exactly, as each partial product
+// of binomials is itself a whole number.
+struct ExactWeight {
+    struct Value {
+        uint64_t high = 0;
+        uint64_t low = 0;
+    };
+
+    static Value zero() { return {0, 0}; }
+    static Value one() { return {0, 1}; }
+
+    static void multiply(Value &weight, int numerator, int denominator)
+    {
+        multiplyBy(weight, uint32_t(numerator));
+        divideBy(weight, uint32_t(denominator));
+    }
+
+    static void multiplyBinomial(Value &weight, int n, int k)
+    {
+        if (k > n) {
+            weight = zero();
+            return;
+        }
+        for (int d = 1; d <= k; ++d) {
+            multiply(weight, n - d + 1, d);
+        }
+    }
+
+    static void add(Value &sum, const Value &weight)
+    {
+        const uint64_t low = sum.low + weight.low;
+        sum.high += weight.high + (low < sum.low ? 1 : 0);
+        sum.low = low;
+    }
+
+    static void addMultiple(Value &sum, const Value &weight, int factor)
+    {
+        Value product = weight;
+        multiplyBy(product, uint32_t(factor));
+        add(sum, product);
+    }
+
+    static bool isZero(const Value &weight)
+    {
+        return weight.high == 0 && weight.low == 0;
+    }
+
+    static double logScale(const Value &) { return 0.0; }
+
+    static double toDouble(const Value &weight, double)
+    {
+        return std::ldexp(double(weight.high), 64) + double(weight.low);
+    }
+
+private:
+    static constexpr uint64_t lowHalf = 0xffffffff;
+
+    static void multiplyBy(Value &weight, uint32_t factor)
+    {
+        const uint64_t low = (weight.low & lowHalf) * factor;
+        const uint64_t middle = (weight.low >> 32) * factor + (low >> 32);
+        weight.low = middle << 32 | (low & lowHalf);
+        weight.high = weight.high * factor + (middle >> 32);
+    }
+
+    // Long division by 32-bit digits, most significant first.
+    static void divideBy(Value &weight, uint32_t divisor)
+    {
+        const uint64_t digits[4] = {weight.high >> 32,
+                                    weight.high & lowHalf,
+                                    weight.low >> 32,
+                                    weight.low & lowHalf};
+        uint64_t quotient[4];
+        uint64_t remainder = 0;
+        for (int i = 0; i < 4; i++) {
+            const uint64_t current = remainder << 32 | digits[i];
+            quotient[i] = current / divisor;
+            remainder = current % divisor;
+        }
+        weight.high = quotient[0] << 32 | quotient[1];
+        weight.low = quotient[2] << 32 | quotient[3];
+    }
+};
@@ -1,15 +1,91 @@
 #include "headers/benchmark.h"
 
 #include "headers/board.h"
+#include "headers/openingbook.h"
+#include "headers/optimalplay.h"
 #include "headers/problemparameters.h"
 #include "headers/solver.h"
 #include <QThread>
 #include <QTime>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <random>
 
-Benchmark::Benchmark(const ProblemParameters &params)
-    : params(params), board(params), solver(params)
+BenchmarkStatistics::BenchmarkStatistics(const ProblemParameters &params)
 {
+    const int numHoles = params.width * params.height;
+    for (int click = 0; click <= numHoles; click++) {
+        constrainedHolesOnClicks.emplace_back(
+            -0.5, numHoles + 0.5, numHoles + 1);
+        partitionsOnClicks.emplace_back(-0.5, numHoles + 1.5, numHoles + 2);
+    }
+    for (int bucket = 0; bucket < probabilityBuckets; bucket++) {
+        probabilityOnBuckets.emplace_back(double(bucket) / probabilityBuckets,
+                                          double(bucket + 1) /
+                                              probabilityBuckets,
+                                          10);
+        goneBadOnBuckets.emplace_back(0.0, 1.0, 2);
+    }
+}
+
+void BenchmarkStatistics::addClick(int click,
+                                   int constrainedHoles,
+                                   int partitions)
+{
+    if (click >= int(constrainedHolesOnClicks.size())) {
+        return;
+    }
+    constrainedHolesOnClicks[click].add(constrainedHoles);
+    partitionsOnClicks[click].add(partitions);
+}
+
+void BenchmarkStatistics::addPick(double probability, bool goneBad)
+{
+    int bucket = int(probability * probabilityBuckets);
+    bucket = std::clamp(bucket, 0, probabilityBuckets - 1);
+    probabilityOnBuckets[bucket].add(probability);
+    goneBadOnBuckets[bucket].add(goneBad ? 1.0 : 0.0);
+}
+
+void BenchmarkStatistics::merge(const BenchmarkStatistics &other)
+{
+    for (size_t i = 0; i < constrainedHolesOnClicks.size() &&
+                       i < other.constrainedHolesOnClicks.size();
+         i++) {
+        constrainedHolesOnClicks[i].merge(other.constrainedHolesOnClicks[i]);
+        partitionsOnClicks[i].merge(other.partitionsOnClicks[i]);
+    }
+    for (int bucket = 0; bucket < probabilityBuckets; bucket++) {
+        probabilityOnBuckets[bucket].merge(other.probabilityOnBuckets[bucket]);
+        goneBadOnBuckets[bucket].merge(other.goneBadOnBuckets[bucket]);
+    }
+    games += other.games;
+    wins += other.wins;
+    totalBadSpots += other.totalBadSpots;
+    totalClicks += other.totalClicks;
+    totalRupees += other.totalRupees;
+    totalProbabilities += other.totalProbabilities;
+}
+
+Benchmark::Benchmark(const ProblemParameters &params,
+                     const BenchmarkOptions &options)
+    : strategies(createMoveStrategies(params, options.rollouts)),
+      params(params),
+      options(options),
+      board(params),
+      solver(params),
+      neighborSums(params),
+      knownBoard(params.width * params.height, DugType::DugType::undug)
+{
+    for (size_t i = 0; i < strategies.size(); i++) {
+        statistics.emplace_back(params);
+    }
+    solver.setOpeningBook(OpeningBook::forParameters(params));
+    if (options.exactCounts) {
+        solver.setEngine(Solver::Engine::partitionEnumeration);
+        solver.setArithmetic(Solver::Arithmetic::exact);
+    }
     moveToThread(&thread);
     //    solver = new Solver*[100];
 
@@ -27,35 +103,20 @@ void Benchmark::start()
 
 void Benchmark::run()
 {
-    wins = 0;
-    totalBadSpots = 0;
-    totalProbabilities = 0.0;
-    totalRupees = 0;
-    totalClicks = 0;
     totalSetupTime = 0;
     totalRunTime = 0;
-    knownBoard = new DugType::DugType *[params.height];
-    probabilityArray = &solver.getProbabilityArray();
-    for (int y = 0; y < params.height; y++) {
-        knownBoard[y] = new DugType::DugType[params.width];
-    }
+    std::random_device dev;
     QTime timer;
     timer.start();
     for (int i = 0; i < 1000; i++) {
-        for (int y = 0; y < params.height; y++) {
-            std::fill(knownBoard[y],
-                      knownBoard[y] + params.width,
-                      DugType::DugType::undug);
+        const uint32_t seed = dev();
+        for (size_t s = 0; s < strategies.size(); s++) {
+            std::fill(
+                knownBoard.begin(), knownBoard.end(), DugType::DugType::undug);
+            solver.reload();
+            board.reload(seed);
+            singleRun(*strategies[s], statistics[s]);
         }
-
-        singleRun();
-        //        for(int j = 0; j < 100; j++)
-        //        {
-        //            solver[j]->reload();
-
-        //        }
-        solver.reload();
-        board.reload();
     }
     //    std::cout << timer.elapsed() << std::endl;
     //        std::cout << totalBadSpots << "\t" << totalProbabilities <<
@@ -72,19 +133,55 @@ void Benchmark::run()
     //                         std::endl;
     //        }
 
-    double numConstrainedAverage;
-    double numPartitionsAverage;
-    for (int key : clicksEncountered.keys()) {
-        numConstrainedAverage = 0.0;
-        numPartitionsAverage = 0.0;
-        for (int i = 0; i < clicksEncountered.value(key); i++) {
-            numConstrainedAverage += constrainedHolesOnClicks.value(key)->at(i);
-            numPartitionsAverage += partitionsOnClicks.value(key)->at(i);
+    for (size_t s = 0; s < strategies.size(); s++) {
+        const BenchmarkStatistics &result = statistics[s];
+        std::cout << strategies[s]->name() << "\t"
+                  << result.wins / double(result.games) << "\t"
+                  << result.totalRupees / double(result.games) << "\t"
+                  << result.totalClicks / double(result.games) << std::endl;
+        for (int click = 0;
+             click < int(result.constrainedHolesOnClicks.size());
+             click++) {
+            const StreamingStatistics &constrainedHoles =
+                result.constrainedHolesOnClicks[click];
+            const StreamingStatistics &partitions =
+                result.partitionsOnClicks[click];
+            if (constrainedHoles.count() == 0) {
+                continue;
+            }
+            std::cout << click << "\t" << constrainedHoles.mean() << "\t"
+                      << partitions.mean() << "\t"
+                      << std::sqrt(constrainedHoles.variance()) << "\t"
+                      << std::sqrt(partitions.variance()) << "\t"
+                      << constrainedHoles.quantile(0.5) << "\t"
+                      << partitions.quantile(0.5) << "\t"
+                      << constrainedHoles.count() << std::endl;
         }
-        numConstrainedAverage /= clicksEncountered.value(key);
-        numPartitionsAverage /= clicksEncountered.value(key);
-        std::cout << key << "\t" << numConstrainedAverage << "\t"
-                  << numPartitionsAverage << std::endl;
+        for (int bucket = 0; bucket < BenchmarkStatistics::probabilityBuckets;
+             bucket++) {
+            const StreamingStatistics &probability =
+                result.probabilityOnBuckets[bucket];
+            if (probability.count() == 0) {
+                continue;
+            }
+            std::cout << probability.mean() << "\t" << probability.count()
+                      << "\t" << result.goneBadOnBuckets[bucket].mean()
+                      << std::endl;
+        }
+    }
+
+    if (options.optimalPlay && OptimalPlay::isFeasible(params)) {
+        std::fill(
+            knownBoard.begin(), knownBoard.end(), DugType::DugType::undug);
+        OptimalPlay optimalPlay(params);
+        std::cout << "Optimal play\t" << optimalPlay.solve(knownBoard) << "\t"
+                  << optimalPlay.bestMove() << std::endl;
+    }
+
+    if (solver.getCacheLookups() > 0) {
+        std::cout << "Transposition cache hit rate\t"
+                  << solver.getCacheHits() / double(solver.getCacheLookups())
+                  << std::endl;
     }
 
     //    for(uint64_t key: partitionIterationsEncountered.keys())
@@ -98,27 +195,19 @@ void Benchmark::run()
     //                     partitionIterationsEncountered.value(key) <<
     //                     std::endl;
     //    }
-    for (int y = 0; y < params.height; y++) {
-        delete[] knownBoard[y];
-    }
-    delete[] knownBoard;
     thread.exit();
     emit done();
 }
 
-void Benchmark::singleRun()
+void Benchmark::singleRun(const MoveStrategy &strategy,
+                          BenchmarkStatistics &statistics)
 {
     QTime timer;
     DugType::DugType newSpot;
-    int index;
-    int filterIndex;
     double lowestprobability;
-    double highestNeighborSum = 0.0;
-    // double ridgedistance;
-    double lowestridgedistance;
-    double neighborSum;
-    int bestX = 0;
-    int bestY = 0;
+    int best;
+    int bestX;
+    int bestY;
     int sumbadspots = 0;
     double sumProbabilities = 0.0;
     int rupees = 0;
@@ -126,7 +215,6 @@ void Benchmark::singleRun()
     double setupTime = 0;
     double runTime = 0;
     // double individualRunTime;
-    double individualSetupTime = 0.0;
 
     int numConstrainedHoles;
     int partitions;
@@ -152,11 +240,6 @@ void Benchmark::singleRun()
     //    partitionIterations = solver[1]->getIterations();
     //    legalIterations = solver[0]->getLegalIterations();
 
-    if (clicksEncountered.contains(clicks)) {
-        clicksEncountered.insert(clicks, clicksEncountered.value(clicks) + 1);
-    } else {
-        clicksEncountered.insert(clicks, 1);
-    }
     //        if(standardIterationsEncountered.contains(standardIterations))
     //        {
     //            standardIterationsEncountered.insert(standardIterations,
@@ -208,133 +291,38 @@ void Benchmark::singleRun()
     //        totalTimeOnPartitions.insert(partitions,
     //        totalTimeOnPartitions.value(partitions) + runTime);
     //    }
-    if (constrainedHolesOnClicks.contains(clicks)) {
-        constrainedHolesOnClicks.value(clicks)->append(numConstrainedHoles);
-        partitionsOnClicks.value(clicks)->append(partitions);
-    } else {
-        constrainedHolesOnClicks.insert(clicks, new QList<int>);
-        partitionsOnClicks.insert(clicks, new QList<int>);
-        constrainedHolesOnClicks.value(clicks)->append(numConstrainedHoles);
-        partitionsOnClicks.value(clicks)->append(partitions);
-    }
+    statistics.addClick(clicks, numConstrainedHoles, partitions);
 
     while (!board.hasWon()) {
-        lowestprobability = 1.0;
-        lowestridgedistance = 1.0;
-        index = 0;
-        for (int y = 0; y < params.height; y++) {
-            for (int x = 0; x < params.width; x++) {
-                if (knownBoard[y][x] == DugType::DugType::undug) {
-                    if ((*probabilityArray)[index] < lowestprobability) {
-                        neighborSum = 0.0;
-                        for (int filterY = y - 1; filterY < y + 2; filterY++) {
-                            if (filterY >= 0 && filterY < params.height) {
-                                for (int filterX = x - 1; filterX < x + 2;
-                                     filterX++) {
-                                    if (filterX >= 0 &&
-                                        filterX < params.width) {
-                                        if (filterX != x || filterY != y) {
-                                            filterIndex =
-                                                filterY * params.width +
-                                                filterX;
-                                            neighborSum += (*probabilityArray)
-                                                [filterIndex];
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                        highestNeighborSum = neighborSum;
-                        lowestprobability = (*probabilityArray)[index];
-                        bestX = x;
-                        bestY = y;
-
-                        //                        lowestridgedistance = 1.0;
-                        //                        for(int i = 0; i < 4; i++)
-                        //                        {
-                        //                            if(std::abs(neighborSum -
-                        //                            ridgepoints[i]) <
-                        //                            lowestridgedistance)
-                        //                            {
-                        //                                lowestridgedistance =
-                        //                                std::abs(neighborSum -
-                        //                                ridgepoints[i]);
-                        //                            }
-                        //                        }
-                    } else if ((*probabilityArray)[index] ==
-                               lowestprobability) {
-                        neighborSum = 0.0;
-                        for (int filterY = y - 1; filterY < y + 2; filterY++) {
-                            if (filterY >= 0 && filterY < params.height) {
-                                for (int filterX = x - 1; filterX < x + 2;
-                                     filterX++) {
-                                    if (filterX >= 0 &&
-                                        filterX < params.width) {
-                                        if (filterX != x || filterY != y) {
-                                            filterIndex =
-                                                filterY * params.width +
-                                                filterX;
-                                            neighborSum += (*probabilityArray)
-                                                [filterIndex];
-                                        }
-                                    }
-                                }
-                            }
-                        }
-
-                        //                        ridgedistance = 1.0;
-                        //                        for(int i = 0; i < 4; i++)
-                        //                        {
-                        //                            if(std::abs(neighborSum -
-                        //                            ridgepoints[i]) <
-                        //                            ridgedistance)
-                        //                            {
-                        //                                ridgedistance =
-                        //                                std::abs(neighborSum -
-                        //                                ridgepoints[i]);
-                        //                            }
-                        //                        }
-                        //                        if(ridgedistance <
-                        //                        lowestridgedistance)
-                        //                        {
-                        //                            bestX = x;
-                        //                            bestY = y;
-                        //                            lowestridgedistance =
-                        //                            ridgedistance;
-                        //                        }
-                        if (neighborSum > highestNeighborSum) {
-                            bestX = x;
-                            bestY = y;
-                            highestNeighborSum = neighborSum;
-                        }
-                    }
-                }
-                index++;
-            }
+        // Refetched after every solve, as sparse storage expands it lazily.
+        probabilityArray = &solver.getProbabilityArray();
+        neighborSums.compute(*probabilityArray);
+        best = strategy.selectMove({params,
+                                    *probabilityArray,
+                                    neighborSums.sums(),
+                                    knownBoard});
+        if (best == -1) {
+            break;
         }
+        lowestprobability = (*probabilityArray)[best];
+        bestX = best % params.width;
+        bestY = best / params.width;
         sumProbabilities += lowestprobability;
         //        if(!probabilityCount.contains(lowestprobability))
         //        {
         //            probabilityCount.insert(lowestprobability, 0);
         //            probabilityGoneBad.insert(lowestprobability, 0);
         //        }
-        probabilityCount.insert(lowestprobability,
-                                probabilityCount.value(lowestprobability) + 1);
         newSpot = board.getCell(bestX, bestY);
         clicks++;
-        knownBoard[bestY][bestX] = newSpot;
+        knownBoard[best] = newSpot;
+        statistics.addPick(lowestprobability, newSpot < 0);
         if (newSpot == DugType::DugType::bomb) {
             sumbadspots++;
-            probabilityGoneBad.insert(
-                lowestprobability,
-                probabilityGoneBad.value(lowestprobability) + 1);
             break;
         }
         if (newSpot == DugType::DugType::rupoor) {
             sumbadspots++;
-            probabilityGoneBad.insert(
-                lowestprobability,
-                probabilityGoneBad.value(lowestprobability) + 1);
             rupees = std::max(rupees - 10, 0);
         } else if (newSpot == DugType::DugType::green) {
             rupees += 1;
@@ -379,16 +367,6 @@ void Benchmark::singleRun()
 
         //        legalIterations = solver[0]->getLegalIterations();
 
-        if (clicksEncountered.contains(clicks)) {
-            clicksEncountered.insert(clicks,
-                                     clicksEncountered.value(clicks) + 1);
-            totalSetupTimeForClicks.insert(
-                clicks,
-                totalSetupTimeForClicks.value(clicks) + individualSetupTime);
-        } else {
-            clicksEncountered.insert(clicks, 1);
-            totalSetupTimeForClicks.insert(clicks, individualSetupTime);
-        }
         //                if(standardIterationsEncountered.contains(standardIterations))
         //                {
         //                    standardIterationsEncountered.insert(standardIterations,
@@ -448,23 +426,16 @@ void Benchmark::singleRun()
         //            totalTimeOnPartitions.insert(partitions,
         //            individualRunTime);
         //        }
-        if (constrainedHolesOnClicks.contains(clicks)) {
-            constrainedHolesOnClicks.value(clicks)->append(numConstrainedHoles);
-            partitionsOnClicks.value(clicks)->append(partitions);
-        } else {
-            constrainedHolesOnClicks.insert(clicks, new QList<int>);
-            partitionsOnClicks.insert(clicks, new QList<int>);
-            constrainedHolesOnClicks.value(clicks)->append(numConstrainedHoles);
-            partitionsOnClicks.value(clicks)->append(partitions);
-        }
+        statistics.addClick(clicks, numConstrainedHoles, partitions);
     }
+    statistics.games++;
     if (board.hasWon()) {
-        wins++;
+        statistics.wins++;
     }
-    totalClicks += clicks;
-    totalBadSpots += sumbadspots;
-    totalProbabilities += sumProbabilities;
-    totalRupees += rupees;
+    statistics.totalClicks += clicks;
+    statistics.totalBadSpots += sumbadspots;
+    statistics.totalProbabilities += sumProbabilities;
+    statistics.totalRupees += rupees;
     totalRunTime += runTime;
     totalSetupTime += setupTime;
 
@@ -1,90 +1,51 @@
 #include "headers/board.h"
 
+#include "headers/neighbortable.h"
 #include "headers/problemparameters.h"
 #include <random>
 
 Board::Board(const ProblemParameters &params)
     : problemParams_(params),
+      neighbors_(NeighborTable::forShape(params.width, params.height)),
       opened_(params.height, params.width),
       boardRep_(params.height, params.width)
 {
-    int holes = params.height * params.width;
-    for (int y = 0; y < params.height; y++) {
-        for (int x = 0; x < params.width; x++) {
-            opened_.set(x, y, false);
-            boardRep_.ref(x, y) = DugType::DugType::green;
-        }
-    }
-    std::random_device dev;
-    std::mt19937 rng(dev());
-    std::uniform_int_distribution<std::mt19937::result_type> dist(0, holes - 1);
-    for (int b = 0; b < params.bombs; b++) {
-        int index = dist(rng);
-        int x = index % params.width;
-        int y = index / params.width;
+    reload();
+}
 
-        if (boardRep_.at(x, y) == DugType::DugType::bomb) {
-            b--;
-            continue;
-        }
-        boardRep_.ref(x, y) = DugType::DugType::bomb;
-    }
-    for (int r = 0; r < params.rupoors; r++) {
-        int index = dist(rng);
-        int x = index % params.width;
-        int y = index / params.width;
+Board::Board(const ProblemParameters &params, const DugType::DugType *layout)
+    : problemParams_(params),
+      neighbors_(NeighborTable::forShape(params.width, params.height)),
+      opened_(params.height, params.width),
+      boardRep_(params.height, params.width)
+{
+    load(layout);
+}
 
-        if (boardRep_.at(x, y) != DugType::DugType::green) {
-            r--;
-            continue;
+void Board::load(const DugType::DugType *layout) &
+{
+    for (int y = 0; y < problemParams_.height; y++) {
+        for (int x = 0; x < problemParams_.width; x++) {
+            opened_.set(x, y, false);
         }
-        boardRep_.ref(x, y) = DugType::DugType::rupoor;
     }
-
-    for (int y = 0; y < params.height; y++) {
-        for (int x = 0; x < params.width; x++) {
-            if (boardRep_.at(x, y) == DugType::DugType::green) {
-                int badspots = 0;
-                for (int filterY = y - 1; filterY < y + 2; filterY++) {
-                    if (filterY >= 0 && filterY < params.height) {
-                        for (int filterX = x - 1; filterX < x + 2; filterX++) {
-                            if (filterX >= 0 && filterX < params.width) {
-                                if (filterX != x || filterY != y) {
-                                    if (boardRep_.at(filterX, filterY) < 0) {
-                                        badspots++;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-                switch (badspots) {
-                case 0:
-                    boardRep_.ref(x, y) = DugType::DugType::green;
-                    break;
-                case 1:
-                case 2:
-                    boardRep_.ref(x, y) = DugType::DugType::blue;
-                    break;
-                case 3:
-                case 4:
-                    boardRep_.ref(x, y) = DugType::DugType::red;
-                    break;
-                case 5:
-                case 6:
-                    boardRep_.ref(x, y) = DugType::DugType::silver;
-                    break;
-                case 7:
-                case 8:
-                    boardRep_.ref(x, y) = DugType::DugType::gold;
-                    break;
-                }
-            }
-        }
+    const int numHoles = problemParams_.height * problemParams_.width;
+    for (int index = 0; index < numHoles; index++) {
+        boardRep_[index] = layout[index] == DugType::DugType::bomb ||
+                                   layout[index] == DugType::DugType::rupoor
+                               ? layout[index]
+                               : DugType::DugType::green;
     }
+    colourRupees();
 }
 
 void Board::reload() &
+{
+    std::random_device dev;
+    reload(dev());
+}
+
+void Board::reload(uint32_t seed) &
 {
     for (int y = 0; y < problemParams_.height; y++) {
         for (int x = 0; x < problemParams_.width; x++) {
@@ -92,8 +53,7 @@ void Board::reload() &
             boardRep_.ref(x, y) = DugType::DugType::green;
         }
     }
-    std::random_device dev;
-    std::mt19937 rng(dev());
+    std::mt19937 rng(seed);
     std::uniform_int_distribution<std::mt19937::result_type> dist(
         0, problemParams_.height * problemParams_.width - 1);
     for (int b = 0; b < problemParams_.bombs; b++) {
@@ -118,48 +78,42 @@ void Board::reload() &
         }
         boardRep_.ref(x, y) = DugType::DugType::rupoor;
     }
+    colourRupees();
+}
 
+void Board::colourRupees()
+{
     int badspots;
-    for (int y = 0; y < problemParams_.height; y++) {
-        for (int x = 0; x < problemParams_.width; x++) {
-            if (boardRep_.at(x, y) == DugType::DugType::green) {
-                badspots = 0;
-                for (int filterY = y - 1; filterY < y + 2; filterY++) {
-                    if (filterY >= 0 && filterY < problemParams_.height) {
-                        for (int filterX = x - 1; filterX < x + 2; filterX++) {
-                            if (filterX >= 0 &&
-                                filterX < problemParams_.width) {
-                                if (filterX != x || filterY != y) {
-                                    if (boardRep_.at(filterX, filterY) < 0) {
-                                        badspots++;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-                switch (badspots) {
-                case 0:
-                    boardRep_.ref(x, y) = DugType::DugType::green;
-                    break;
-                case 1:
-                case 2:
-                    boardRep_.ref(x, y) = DugType::DugType::blue;
-                    break;
-                case 3:
-                case 4:
-                    boardRep_.ref(x, y) = DugType::DugType::red;
-                    break;
-                case 5:
-                case 6:
-                    boardRep_.ref(x, y) = DugType::DugType::silver;
-                    break;
-                case 7:
-                case 8:
-                    boardRep_.ref(x, y) = DugType::DugType::gold;
-                    break;
+    const int numHoles = problemParams_.height * problemParams_.width;
+    for (int index = 0; index < numHoles; index++) {
+        if (boardRep_[index] == DugType::DugType::green) {
+            badspots = 0;
+            for (int neighbor : (*neighbors_)[index]) {
+                if (boardRep_[neighbor] < 0) {
+                    badspots++;
                 }
             }
+            switch (badspots) {
+            case 0:
+                boardRep_[index] = DugType::DugType::green;
+                break;
+            case 1:
+            case 2:
+                boardRep_[index] = DugType::DugType::blue;
+                break;
+            case 3:
+            case 4:
+                boardRep_[index] = DugType::DugType::red;
+                break;
+            case 5:
+            case 6:
+                boardRep_[index] = DugType::DugType::silver;
+                break;
+            case 7:
+            case 8:
+                boardRep_[index] = DugType::DugType::gold;
+                break;
+            }
         }
     }
 }
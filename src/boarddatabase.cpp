@@ -0,0 +1,190 @@
+#include "headers/boarddatabase.h"
+
+#include "headers/neighbortable.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <tuple>
+
+namespace
+{
+
+// Branch-free bit counting, as std::bitset::count falls back to a slow
+// loop when the compiler may not use a popcount instruction.
+int popcount(uint64_t word)
+{
+    word -= (word >> 1) & 0x5555555555555555;
+    word = (word & 0x3333333333333333) + ((word >> 2) & 0x3333333333333333);
+    word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0f;
+    return int((word * 0x0101010101010101) >> 56);
+}
+
+// Bad is 0; green to gold, showing 0, 1-2, 3-4, 5-6 and 7-8 bad
+// neighbours, are 1 to 5.
+int clueOfNeighbors(int badNeighbors)
+{
+    return badNeighbors == 0 ? 1 : (badNeighbors + 1) / 2 + 1;
+}
+
+int clueOfType(DugType::DugType type)
+{
+    return type < 0 ? 0 : type / 2 + 1;
+}
+
+} // namespace
+
+BoardDatabase::BoardDatabase(const ProblemParameters &params)
+    : numHoles_(params.width * params.height),
+      layouts_(layoutCount(params)),
+      words_((layouts_ + 63) / 64),
+      bits_(size_t(numHoles_) * clueCount * words_, 0)
+{
+    const std::shared_ptr<const NeighborTable> neighbors =
+        NeighborTable::forShape(params.width, params.height);
+    std::vector<uint64_t> neighborMasks(numHoles_, 0);
+    for (int i = 0; i < numHoles_; i++) {
+        for (int neighbor : (*neighbors)[i]) {
+            neighborMasks[i] |= uint64_t(1) << neighbor;
+        }
+    }
+
+    // Layouts are the combinations of bad cells in lexicographic order.
+    const int bad = params.bombs + params.rupoors;
+    std::vector<int> chosen(bad);
+    std::iota(chosen.begin(), chosen.end(), 0);
+    for (uint64_t layout = 0; layout < layouts_; layout++) {
+        uint64_t mask = 0;
+        for (int cell : chosen) {
+            mask |= uint64_t(1) << cell;
+        }
+        const size_t word = layout / 64;
+        const uint64_t bit = uint64_t(1) << (layout % 64);
+        for (int i = 0; i < numHoles_; i++) {
+            const int clue = (mask >> i & 1) != 0
+                                 ? 0
+                                 : clueOfNeighbors(
+                                       popcount(mask & neighborMasks[i]));
+            clueBits(i, clue)[word] |= bit;
+        }
+
+        int k = bad - 1;
+        while (k >= 0 && chosen[k] == numHoles_ - bad + k) {
+            k--;
+        }
+        if (k < 0) {
+            break;
+        }
+        chosen[k]++;
+        for (int j = k + 1; j < bad; j++) {
+            chosen[j] = chosen[j - 1] + 1;
+        }
+    }
+}
+
+uint64_t BoardDatabase::layoutCount(const ProblemParameters &params)
+{
+    const int n = params.width * params.height;
+    const int bad = params.bombs + params.rupoors;
+    if (bad < 0 || bad > n) {
+        return 0;
+    }
+    // C(n - k + i, i) grows with i, so the count can stop at the limit.
+    const int k = std::min(bad, n - bad);
+    uint64_t count = 1;
+    for (int i = 1; i <= k; i++) {
+        count = count * uint64_t(n - k + i) / uint64_t(i);
+        if (count > maxLayouts) {
+            return maxLayouts + 1;
+        }
+    }
+    return count;
+}
+
+bool BoardDatabase::isSuitable(const ProblemParameters &params)
+{
+    const int numHoles = params.width * params.height;
+    return numHoles > 0 && numHoles <= 64 &&
+           layoutCount(params) <= maxLayouts;
+}
+
+std::shared_ptr<const BoardDatabase>
+BoardDatabase::forParameters(const ProblemParameters &params)
+{
+    if (!isSuitable(params)) {
+        return nullptr;
+    }
+    static std::mutex mutex;
+    static std::map<std::tuple<int, int, int>,
+                    std::weak_ptr<const BoardDatabase>>
+        databases;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &entry = databases[{
+        params.width, params.height, params.bombs + params.rupoors}];
+    std::shared_ptr<const BoardDatabase> database = entry.lock();
+    if (database == nullptr) {
+        database = std::make_shared<const BoardDatabase>(params);
+        entry = database;
+    }
+    return database;
+}
+
+double BoardDatabase::solve(const DugType::DugType *types,
+                            std::vector<double> &badWeight,
+                            std::vector<uint64_t> &consistent) const
+{
+    consistent.assign(words_, ~uint64_t(0));
+    if (layouts_ % 64 != 0) {
+        consistent.back() = (uint64_t(1) << (layouts_ % 64)) - 1;
+    }
+    for (int i = 0; i < numHoles_; i++) {
+        if (types[i] == DugType::undug) {
+            continue;
+        }
+        const uint64_t *bits = clueBits(i, clueOfType(types[i]));
+        for (size_t w = 0; w < words_; w++) {
+            consistent[w] &= bits[w];
+        }
+    }
+
+    // Only the words between the first and last surviving layout are
+    // counted.
+    size_t first = 0;
+    size_t last = words_;
+    while (first < last && consistent[first] == 0) {
+        first++;
+    }
+    while (last > first && consistent[last - 1] == 0) {
+        last--;
+    }
+    uint64_t total = 0;
+    for (size_t w = first; w < last; w++) {
+        total += popcount(consistent[w]);
+    }
+
+    badWeight.resize(numHoles_);
+    for (int i = 0; i < numHoles_; i++) {
+        if (types[i] != DugType::undug) {
+            badWeight[i] = types[i] < 0 ? double(total) : 0.0;
+            continue;
+        }
+        const uint64_t *bits = clueBits(i, 0);
+        uint64_t count = 0;
+        for (size_t w = first; w < last; w++) {
+            count += popcount(consistent[w] & bits[w]);
+        }
+        badWeight[i] = double(count);
+    }
+    return double(total);
+}
+
+uint64_t *BoardDatabase::clueBits(int cell, int clue)
+{
+    return &bits_[(size_t(cell) * clueCount + clue) * words_];
+}
+
+const uint64_t *BoardDatabase::clueBits(int cell, int clue) const
+{
+    return &bits_[(size_t(cell) * clueCount + clue) * words_];
+}
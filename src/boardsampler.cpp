@@ -0,0 +1,473 @@
+#include "headers/boardsampler.h"
+
+#include "headers/frontier.h"
+#include "headers/solver.h"
+#include <algorithm>
+#include <map>
+#include <numeric>
+
+namespace
+{
+
+// A class shares a constraint, so it holds at most eight holes.
+const int choices = 9;
+
+double smallChoose(int n, int k)
+{
+    double result = 1.0;
+    for (int i = 0; i < k; i++) {
+        result = result * (n - i) / (i + 1);
+    }
+    return result;
+}
+
+// Moves `count` uniformly chosen entries of `items` to its front.
+void pickFront(std::vector<int> &items, int count, std::mt19937 &rng)
+{
+    for (int i = 0; i < count; i++) {
+        std::uniform_int_distribution<int> dist(i, int(items.size()) - 1);
+        std::swap(items[i], items[dist(rng)]);
+    }
+}
+
+// Index of the entry of `weights` that `target` falls into when the weights
+// are laid end to end.
+int pickWeighted(const std::vector<double> &weights, double target)
+{
+    int last = -1;
+    for (int i = 0; i < int(weights.size()); i++) {
+        if (weights[i] <= 0.0) {
+            continue;
+        }
+        last = i;
+        if (target < weights[i]) {
+            return i;
+        }
+        target -= weights[i];
+    }
+    return last;
+}
+
+} // namespace
+
+BoardSampler::BoardSampler(const ProblemParameters &params)
+    : params_(params), numHoles_(params.width * params.height)
+{
+}
+
+bool BoardSampler::prepare(Solver &solver)
+{
+    const FrontierProblem &problem = solver.getFrontierProblem();
+    revealed_.resize(numHoles_);
+    knownBad_.clear();
+    unconstrained_.clear();
+    int revealedBombs = 0;
+    int revealedRupoors = 0;
+    for (int i = 0; i < numHoles_; i++) {
+        revealed_[i] = solver.getCellType(i);
+        if (revealed_[i] == DugType::DugType::bomb) {
+            revealedBombs++;
+        } else if (revealed_[i] == DugType::DugType::rupoor) {
+            revealedRupoors++;
+        } else if (revealed_[i] == DugType::DugType::undug) {
+            const Solver::HoleState state = solver.getHoleState(i);
+            if (state == Solver::HoleState::knownBad) {
+                knownBad_.push_back(i);
+            } else if (state == Solver::HoleState::unconstrained) {
+                unconstrained_.push_back(i);
+            }
+        }
+    }
+    hiddenBombs_ = params_.bombs - revealedBombs;
+    badSpots_ = problem.badSpots;
+    if (hiddenBombs_ < 0 || params_.rupoors < revealedRupoors ||
+        badSpots_ < 0) {
+        return false;
+    }
+
+    buildClasses(problem.holes, problem.constraintHoles);
+    return buildComponents(problem.constraintHoles, problem.maxBadness) &&
+           buildTails();
+}
+
+void BoardSampler::sample(std::mt19937 &rng,
+                          std::vector<DugType::DugType> &layout) const
+{
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<int> bad(knownBad_);
+    std::vector<double> weights;
+    std::vector<int> holes;
+    int used = 0;
+    for (size_t c = 0; c < components_.size(); c++) {
+        const Component &component = components_[c];
+        const std::vector<double> &counts = component.counts;
+        const std::vector<double> &tail = tails_[c + 1];
+        weights.assign(counts.size(), 0.0);
+        double total = 0.0;
+        for (int k = 0; k < int(weights.size()) && used + k <= badSpots_;
+             k++) {
+            weights[k] = counts[k] * tail[used + k];
+            total += weights[k];
+        }
+        int left = pickWeighted(weights, unit(rng) * total);
+        used += left;
+
+        int state = 0;
+        for (size_t t = 0; t < component.classes.size(); t++) {
+            const std::vector<int> &next = component.next[t];
+            const int size = int(classes_[component.classes[t]].holes.size());
+            weights.assign(size + 1, 0.0);
+            total = 0.0;
+            for (int j = 0; j <= size && j <= left; j++) {
+                const int target = next[state * choices + j];
+                if (target != -1) {
+                    weights[j] =
+                        smallChoose(size, j) *
+                        waysOf(component, int(t) + 1, target, left - j);
+                    total += weights[j];
+                }
+            }
+            const int j = pickWeighted(weights, unit(rng) * total);
+            holes = classes_[component.classes[t]].holes;
+            pickFront(holes, j, rng);
+            bad.insert(bad.end(), holes.begin(), holes.begin() + j);
+            state = next[state * choices + j];
+            left -= j;
+        }
+    }
+    holes = unconstrained_;
+    pickFront(holes, badSpots_ - used, rng);
+    bad.insert(bad.end(), holes.begin(), holes.begin() + (badSpots_ - used));
+
+    // Which hidden bad spots hold the bombs is independent of everything
+    // revealed.
+    pickFront(bad, hiddenBombs_, rng);
+    layout.assign(numHoles_, DugType::DugType::green);
+    for (int i = 0; i < int(bad.size()); i++) {
+        layout[bad[i]] = i < hiddenBombs_ ? DugType::DugType::bomb
+                                          : DugType::DugType::rupoor;
+    }
+    for (int i = 0; i < numHoles_; i++) {
+        if (revealed_[i] == DugType::DugType::bomb ||
+            revealed_[i] == DugType::DugType::rupoor) {
+            layout[i] = revealed_[i];
+        }
+    }
+}
+
+Board BoardSampler::sampleBoard(std::mt19937 &rng) const
+{
+    std::vector<DugType::DugType> layout;
+    sample(rng, layout);
+    Board board(params_, layout.data());
+    for (int i = 0; i < numHoles_; i++) {
+        if (revealed_[i] != DugType::DugType::undug) {
+            board.getCell(i % params_.width, i / params_.width);
+        }
+    }
+    return board;
+}
+
+// Frontier holes outside every open constraint are as free as the
+// unconstrained holes and join them.
+void BoardSampler::buildClasses(
+    const std::vector<int> &holes,
+    const std::vector<std::vector<int>> &constraintHoles)
+{
+    std::vector<std::vector<int>> membership(holes.size());
+    for (int c = 0; c < int(constraintHoles.size()); c++) {
+        for (int position : constraintHoles[c]) {
+            membership[position].push_back(c);
+        }
+    }
+    classes_.clear();
+    std::map<std::vector<int>, int> classOf;
+    for (size_t p = 0; p < holes.size(); p++) {
+        if (membership[p].empty()) {
+            unconstrained_.push_back(holes[p]);
+            continue;
+        }
+        const auto inserted =
+            classOf.insert({membership[p], int(classes_.size())});
+        if (inserted.second) {
+            classes_.push_back({{}, membership[p]});
+        }
+        classes_[inserted.first->second].holes.push_back(holes[p]);
+    }
+}
+
+bool BoardSampler::buildComponents(
+    const std::vector<std::vector<int>> &constraintHoles,
+    const std::vector<int> &maxBadness)
+{
+    const int numConstraints = int(constraintHoles.size());
+    std::vector<std::vector<int>> constraintClasses(numConstraints);
+    for (int i = 0; i < int(classes_.size()); i++) {
+        for (int c : classes_[i].constraints) {
+            constraintClasses[c].push_back(i);
+        }
+    }
+    for (int c = 0; c < numConstraints; c++) {
+        if (constraintClasses[c].empty() && maxBadness[c] > 1) {
+            return false;
+        }
+    }
+
+    // Classes are visited breadth first, so that constraints close soon
+    // after they open and few are open at once.
+    components_.clear();
+    first_.assign(numConstraints, -1);
+    last_.assign(numConstraints, -1);
+    remaining_.assign(numConstraints, 0);
+    openPosition_.assign(numConstraints, -1);
+    std::vector<bool> visited(classes_.size(), false);
+    int entries = 0;
+    for (int start = 0; start < int(classes_.size()); start++) {
+        if (visited[start]) {
+            continue;
+        }
+        Component component;
+        visited[start] = true;
+        component.classes.push_back(start);
+        for (size_t next = 0; next < component.classes.size(); next++) {
+            const int current = component.classes[next];
+            for (int c : classes_[current].constraints) {
+                for (int other : constraintClasses[c]) {
+                    if (!visited[other]) {
+                        visited[other] = true;
+                        component.classes.push_back(other);
+                    }
+                }
+            }
+        }
+        if (!buildTables(component, maxBadness, entries)) {
+            return false;
+        }
+        components_.push_back(std::move(component));
+    }
+    return true;
+}
+
+bool BoardSampler::buildTables(Component &component,
+                               const std::vector<int> &maxBadness,
+                               int &entries)
+{
+    const int numClasses = int(component.classes.size());
+    std::vector<int> holesFrom(numClasses + 1, 0);
+    for (int t = numClasses - 1; t >= 0; t--) {
+        const HoleClass &holeClass = classes_[component.classes[t]];
+        holesFrom[t] = holesFrom[t + 1] + int(holeClass.holes.size());
+        for (int c : holeClass.constraints) {
+            first_[c] = t;
+            last_[c] = std::max(last_[c], t);
+            remaining_[c] += int(holeClass.holes.size());
+        }
+    }
+
+    // Forward: the states reachable at every layer, keyed by the sums of the
+    // open constraints in `open` order.
+    component.next.assign(numClasses, {});
+    std::vector<int> open;
+    std::vector<int> nextOpen;
+    std::vector<std::vector<uint8_t>> keys(1);
+    std::vector<std::vector<uint8_t>> nextKeys;
+    std::map<std::vector<uint8_t>, int> states;
+    std::vector<uint8_t> key;
+    bool fits = true;
+    for (int t = 0; t < numClasses && fits; t++) {
+        const HoleClass &holeClass = classes_[component.classes[t]];
+        const int size = int(holeClass.holes.size());
+        for (int c : holeClass.constraints) {
+            remaining_[c] -= size;
+        }
+        nextOpen.clear();
+        for (int c : open) {
+            if (last_[c] != t) {
+                nextOpen.push_back(c);
+            }
+        }
+        for (int c : holeClass.constraints) {
+            if (first_[c] == t && last_[c] != t) {
+                nextOpen.push_back(c);
+            }
+        }
+
+        std::vector<int> &next = component.next[t];
+        next.assign(keys.size() * choices, -1);
+        states.clear();
+        nextKeys.clear();
+        for (size_t s = 0; s < keys.size(); s++) {
+            for (int j = 0; j <= size; j++) {
+                bool legal = true;
+                bool over = false;
+                for (int c : holeClass.constraints) {
+                    const int position = openPosition_[c];
+                    const int sum =
+                        (position == -1 ? 0 : keys[s][position]) + j;
+                    over = over || sum > maxBadness[c];
+                    legal = legal && sum + remaining_[c] >= maxBadness[c] - 1;
+                }
+                if (over) {
+                    break;
+                }
+                if (!legal) {
+                    continue;
+                }
+                key.clear();
+                for (int c : nextOpen) {
+                    const int position = openPosition_[c];
+                    const bool touched =
+                        std::binary_search(holeClass.constraints.begin(),
+                                           holeClass.constraints.end(),
+                                           c);
+                    key.push_back(
+                        uint8_t((position == -1 ? 0 : keys[s][position]) +
+                                (touched ? j : 0)));
+                }
+                const auto inserted =
+                    states.insert({key, int(nextKeys.size())});
+                if (inserted.second) {
+                    nextKeys.push_back(key);
+                }
+                next[s * choices + j] = inserted.first->second;
+            }
+        }
+
+        for (int c : open) {
+            openPosition_[c] = -1;
+        }
+        for (int i = 0; i < int(nextOpen.size()); i++) {
+            openPosition_[nextOpen[i]] = i;
+        }
+        open.swap(nextOpen);
+        keys.swap(nextKeys);
+        entries += int(next.size());
+        fits = entries <= maxTableEntries;
+    }
+    for (int c : open) {
+        openPosition_[c] = -1;
+    }
+    for (int i : component.classes) {
+        for (int c : classes_[i].constraints) {
+            first_[c] = -1;
+            last_[c] = -1;
+            remaining_[c] = 0;
+        }
+    }
+    if (!fits) {
+        return false;
+    }
+
+    // Backward: every constraint has closed by the last layer, which holds
+    // at most the one empty state. The bad count ranges come first, so that
+    // only counts a state can finish with get an entry.
+    component.low.assign(numClasses + 1, {});
+    component.high.assign(numClasses + 1, {});
+    component.offsets.assign(numClasses + 1, {});
+    component.ways.assign(numClasses + 1, {});
+    component.low[numClasses].assign(keys.size(), 0);
+    component.high[numClasses].assign(keys.size(), 0);
+    component.offsets[numClasses].assign(keys.size() + 1, 0);
+    component.ways[numClasses].assign(keys.size(), 1.0);
+    std::iota(component.offsets[numClasses].begin(),
+              component.offsets[numClasses].end(),
+              0);
+    for (int t = numClasses - 1; t >= 0; t--) {
+        const int size = int(classes_[component.classes[t]].holes.size());
+        const std::vector<int> &next = component.next[t];
+        const int numStates = int(next.size()) / choices;
+        std::vector<int> &low = component.low[t];
+        std::vector<int> &high = component.high[t];
+        std::vector<int> &offsets = component.offsets[t];
+        low.assign(numStates, holesFrom[t] + 1);
+        high.assign(numStates, -1);
+        offsets.assign(numStates + 1, 0);
+        for (int s = 0; s < numStates; s++) {
+            for (int j = 0; j <= size; j++) {
+                const int target = next[s * choices + j];
+                if (target != -1 &&
+                    component.low[t + 1][target] <=
+                        component.high[t + 1][target]) {
+                    low[s] = std::min(low[s], j + component.low[t + 1][target]);
+                    high[s] =
+                        std::max(high[s], j + component.high[t + 1][target]);
+                }
+            }
+            offsets[s + 1] = offsets[s] + std::max(high[s] - low[s] + 1, 0);
+        }
+        entries += offsets[numStates];
+        if (entries > maxTableEntries) {
+            return false;
+        }
+
+        std::vector<double> &ways = component.ways[t];
+        ways.assign(offsets[numStates], 0.0);
+        for (int s = 0; s < numStates; s++) {
+            for (int j = 0; j <= size; j++) {
+                const int target = next[s * choices + j];
+                if (target == -1) {
+                    continue;
+                }
+                const double weight = smallChoose(size, j);
+                for (int b = component.low[t + 1][target];
+                     b <= component.high[t + 1][target];
+                     b++) {
+                    ways[offsets[s] + b + j - low[s]] +=
+                        weight * waysOf(component, t + 1, target, b);
+                }
+            }
+        }
+        const double scale =
+            ways.empty() ? 0.0 : *std::max_element(ways.begin(), ways.end());
+        if (scale > 0.0) {
+            for (double &value : ways) {
+                value /= scale;
+            }
+        }
+    }
+
+    component.counts.assign(holesFrom[0] + 1, 0.0);
+    for (int b = component.low[0][0]; b <= component.high[0][0]; b++) {
+        component.counts[b] = waysOf(component, 0, 0, b);
+    }
+    return true;
+}
+
+bool BoardSampler::buildTails()
+{
+    const int numComponents = int(components_.size());
+    tails_.resize(numComponents + 1);
+    buildCompletions(
+        int(unconstrained_.size()), badSpots_, tails_[numComponents]);
+    for (int c = numComponents - 1; c >= 0; c--) {
+        const std::vector<double> &counts = components_[c].counts;
+        const std::vector<double> &next = tails_[c + 1];
+        std::vector<double> &row = tails_[c];
+        row.assign(badSpots_ + 1, 0.0);
+        for (int used = 0; used <= badSpots_; used++) {
+            for (int k = 0; k < int(counts.size()) && used + k <= badSpots_;
+                 k++) {
+                row[used] += counts[k] * next[used + k];
+            }
+        }
+        const double scale = *std::max_element(row.begin(), row.end());
+        if (scale > 0.0) {
+            for (double &value : row) {
+                value /= scale;
+            }
+        }
+    }
+    return tails_[0][0] > 0.0;
+}
+
+double BoardSampler::waysOf(const Component &component,
+                            int t,
+                            int state,
+                            int bad) const
+{
+    const int low = component.low[t][state];
+    if (bad < low || bad > component.high[t][state]) {
+        return 0.0;
+    }
+    return component.ways[t][component.offsets[t][state] + bad - low];
+}
@@ -0,0 +1,322 @@
+#include "headers/boardwidget.h"
+
+#include <QAction>
+#include <QFocusEvent>
+#include <QKeyEvent>
+#include <QMenu>
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QPen>
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+
+struct TypeInfo {
+    DugType::DugType type;
+    const char *name;
+    QColor colour;
+};
+
+// In menu order, which is also the order of the digit keys.
+const TypeInfo typeInfos[] = {
+    {DugType::undug, "Undug", QColor()},
+    {DugType::bomb, "Bomb", QColor(0, 0, 0)},
+    {DugType::rupoor, "Rupoor", QColor(128, 128, 128)},
+    {DugType::green, "Green", QColor(0, 128, 0)},
+    {DugType::blue, "Blue", QColor(0, 0, 255)},
+    {DugType::red, "Red", QColor(255, 0, 0)},
+    {DugType::silver, "Silver", QColor(192, 192, 192)},
+    {DugType::gold, "Gold", QColor(255, 215, 0)}};
+
+const int preferredCellWidth = 80;
+const int preferredCellHeight = 40;
+const int minimumCellSize = 6;
+const int maximumHintWidth = 960;
+const int maximumHintHeight = 640;
+
+QColor colourOf(DugType::DugType type)
+{
+    for (const TypeInfo &info : typeInfos) {
+        if (info.type == type) {
+            return info.colour;
+        }
+    }
+    return QColor();
+}
+
+} // namespace
+
+BoardWidget::BoardWidget(QWidget *parent) : QWidget(parent)
+{
+    setFocusPolicy(Qt::StrongFocus);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+}
+
+void BoardWidget::resizeBoard(int width, int height)
+{
+    boardWidth_ = width;
+    boardHeight_ = height;
+    cursor_ = 0;
+    cells_.assign(size_t(width) * height, Cell());
+    updateGeometry();
+    update();
+}
+
+void BoardWidget::setEditable(bool editable)
+{
+    editable_ = editable;
+}
+
+DugType::DugType BoardWidget::cell(int x, int y) const
+{
+    return cells_[y * boardWidth_ + x].type;
+}
+
+void BoardWidget::setCell(int x, int y, DugType::DugType type)
+{
+    const int index = y * boardWidth_ + x;
+    if (cells_[index].type != type) {
+        cells_[index].type = type;
+        updateCell(index);
+    }
+}
+
+void BoardWidget::setProbabilities(const std::vector<double> &probabilities,
+                                   const std::vector<int> &lowestRisk)
+{
+    std::vector<bool> highlighted(cells_.size(), false);
+    for (int index : lowestRisk) {
+        highlighted[index] = true;
+    }
+    for (size_t i = 0; i < cells_.size(); i++) {
+        Cell &cell = cells_[i];
+        if (cell.probability != probabilities[i] ||
+            cell.highlighted != highlighted[i]) {
+            cell.probability = probabilities[i];
+            cell.highlighted = highlighted[i];
+            updateCell(int(i));
+        }
+    }
+}
+
+QSize BoardWidget::sizeHint() const
+{
+    const int columns = std::max(boardWidth_, 1);
+    const int rows = std::max(boardHeight_, 1);
+    const int cellWidth = std::clamp(
+        maximumHintWidth / columns, minimumCellSize, preferredCellWidth);
+    const int cellHeight = std::clamp(
+        maximumHintHeight / rows, minimumCellSize, preferredCellHeight);
+    return QSize(columns * cellWidth, rows * cellHeight);
+}
+
+QSize BoardWidget::minimumSizeHint() const
+{
+    return QSize(std::max(boardWidth_, 1) * minimumCellSize,
+                 std::max(boardHeight_, 1) * minimumCellSize);
+}
+
+void BoardWidget::paintEvent(QPaintEvent *event)
+{
+    if (cells_.empty()) {
+        return;
+    }
+    QPainter painter(this);
+    const QRect exposed = event->rect();
+    const int first = cellAt(exposed.topLeft());
+    const int last = cellAt(exposed.bottomRight());
+    const int x0 = first % boardWidth_;
+    const int y0 = first / boardWidth_;
+    const int x1 = last % boardWidth_;
+    const int y1 = last / boardWidth_;
+
+    const QFontMetrics metrics = fontMetrics();
+    const int longText = metrics.horizontalAdvance("100.00% Bad");
+    const int shortText = metrics.horizontalAdvance("100.00%");
+    const QColor undug = palette().color(QPalette::Button);
+    const QColor highlight(0, 255, 255);
+    const QColor grid = palette().color(QPalette::Mid);
+
+    painter.setPen(palette().color(QPalette::ButtonText));
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            const int index = y * boardWidth_ + x;
+            const Cell &cell = cells_[index];
+            const QRect rect = cellRect(index);
+            const bool isUndug = cell.type == DugType::undug;
+            if (!isUndug) {
+                painter.fillRect(rect, colourOf(cell.type));
+            } else {
+                painter.fillRect(rect, cell.highlighted ? highlight : undug);
+            }
+            if (isUndug && cell.probability >= 0.0 &&
+                rect.width() > shortText && rect.height() > metrics.height()) {
+                QString text =
+                    QString::number(cell.probability * 100, 'f', 2) + "%";
+                if (rect.width() > longText) {
+                    text += " Bad";
+                }
+                painter.drawText(rect, Qt::AlignCenter, text);
+            }
+        }
+    }
+
+    painter.setPen(grid);
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            const QRect rect = cellRect(y * boardWidth_ + x);
+            painter.drawRect(rect.adjusted(0, 0, -1, -1));
+        }
+    }
+    if (hasFocus() && exposed.intersects(cellRect(cursor_))) {
+        painter.setPen(QPen(palette().color(QPalette::Highlight), 2));
+        painter.drawRect(cellRect(cursor_).adjusted(1, 1, -1, -1));
+    }
+}
+
+void BoardWidget::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton || cells_.empty()) {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+    const int index = cellAt(event->pos());
+    const int previous = cursor_;
+    cursor_ = index;
+    updateCell(previous);
+    updateCell(cursor_);
+    activate(index, event->pos());
+}
+
+void BoardWidget::keyPressEvent(QKeyEvent *event)
+{
+    if (cells_.empty()) {
+        QWidget::keyPressEvent(event);
+        return;
+    }
+    const int key = event->key();
+    switch (key) {
+    case Qt::Key_Left:
+        moveCursor(-1, 0);
+        return;
+    case Qt::Key_Right:
+        moveCursor(1, 0);
+        return;
+    case Qt::Key_Up:
+        moveCursor(0, -1);
+        return;
+    case Qt::Key_Down:
+        moveCursor(0, 1);
+        return;
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+    case Qt::Key_Space:
+        activate(cursor_, cellRect(cursor_).center());
+        return;
+    }
+    const int digit = key - Qt::Key_0;
+    if (editable_ && digit >= 0 && digit < int(std::size(typeInfos))) {
+        const DugType::DugType type = typeInfos[digit].type;
+        if (cells_[cursor_].type != type) {
+            emit cellEdited(cursor_ % boardWidth_, cursor_ / boardWidth_, type);
+        }
+        return;
+    }
+    QWidget::keyPressEvent(event);
+}
+
+void BoardWidget::focusInEvent(QFocusEvent *event)
+{
+    updateCell(cursor_);
+    QWidget::focusInEvent(event);
+}
+
+void BoardWidget::focusOutEvent(QFocusEvent *event)
+{
+    updateCell(cursor_);
+    QWidget::focusOutEvent(event);
+}
+
+// Cell edges are spread over the whole widget, so that cells differ by at
+// most one pixel in size.
+QRect BoardWidget::cellRect(int index) const
+{
+    const int x = index % boardWidth_;
+    const int y = index / boardWidth_;
+    const int left = x * width() / boardWidth_;
+    const int top = y * height() / boardHeight_;
+    const int right = (x + 1) * width() / boardWidth_;
+    const int bottom = (y + 1) * height() / boardHeight_;
+    return QRect(left, top, right - left, bottom - top);
+}
+
+int BoardWidget::cellAt(const QPoint &point) const
+{
+    const int px = std::clamp(point.x(), 0, std::max(width() - 1, 0));
+    const int py = std::clamp(point.y(), 0, std::max(height() - 1, 0));
+    int x = std::min(px * boardWidth_ / std::max(width(), 1), boardWidth_ - 1);
+    int y =
+        std::min(py * boardHeight_ / std::max(height(), 1), boardHeight_ - 1);
+    // The integer edges of cellRect round differently; step onto the cell
+    // that actually contains the point.
+    while (x > 0 && px < x * width() / boardWidth_) {
+        x--;
+    }
+    while (x < boardWidth_ - 1 && px >= (x + 1) * width() / boardWidth_) {
+        x++;
+    }
+    while (y > 0 && py < y * height() / boardHeight_) {
+        y--;
+    }
+    while (y < boardHeight_ - 1 && py >= (y + 1) * height() / boardHeight_) {
+        y++;
+    }
+    return y * boardWidth_ + x;
+}
+
+void BoardWidget::activate(int index, const QPoint &menuPosition)
+{
+    const int x = index % boardWidth_;
+    const int y = index / boardWidth_;
+    if (!editable_) {
+        if (cells_[index].type == DugType::undug) {
+            emit cellActivated(x, y);
+        }
+        return;
+    }
+    QMenu menu(this);
+    for (const TypeInfo &info : typeInfos) {
+        QAction *action = menu.addAction(info.name);
+        action->setData(int(info.type));
+        action->setCheckable(true);
+        action->setChecked(info.type == cells_[index].type);
+    }
+    QAction *chosen = menu.exec(mapToGlobal(menuPosition));
+    if (chosen == nullptr) {
+        return;
+    }
+    const auto type = DugType::DugType(chosen->data().toInt());
+    if (type != cells_[index].type) {
+        emit cellEdited(x, y, type);
+    }
+}
+
+void BoardWidget::moveCursor(int dx, int dy)
+{
+    const int x = std::clamp(cursor_ % boardWidth_ + dx, 0, boardWidth_ - 1);
+    const int y = std::clamp(cursor_ / boardWidth_ + dy, 0, boardHeight_ - 1);
+    const int previous = cursor_;
+    cursor_ = y * boardWidth_ + x;
+    updateCell(previous);
+    updateCell(cursor_);
+}
+
+void BoardWidget::updateCell(int index)
+{
+    if (index >= 0 && index < int(cells_.size())) {
+        update(cellRect(index));
+    }
+}
@@ -0,0 +1,220 @@
+#include "headers/columnsweep.h"
+
+#include <algorithm>
+#include <bitset>
+#include <numeric>
+
+namespace
+{
+
+int popcount(uint32_t mask)
+{
+    return int(std::bitset<32>(mask).count());
+}
+
+} // namespace
+
+ColumnSweep::ColumnSweep(const ProblemParameters &params)
+    : width_(params.width),
+      alongX_(params.width >= params.height),
+      sliceCount_(alongX_ ? params.width : params.height)
+{
+}
+
+bool ColumnSweep::isSuitable(const ProblemParameters &params)
+{
+    return std::min(params.width, params.height) <= maxSliceLength;
+}
+
+void ColumnSweep::solve(const FrontierProblem &problem,
+                        FrontierSolution &solution)
+{
+    const int badSpots = problem.badSpots;
+    const int unconstrainedHoles = problem.unconstrainedHoles;
+    solution.badWeight.assign(problem.holes.size(), 0.0);
+    solution.outcomes.assign(problem.holes.size(), 0);
+    solution.unconstrainedBadWeight = 0.0;
+    solution.unconstrainedOutcomes = 0;
+    solution.totalWeight = 0.0;
+    solution.logScale = 0.0;
+    solution.iterations = 0;
+    solution.legalIterations = 0;
+    solution.partitions = 0;
+    if (badSpots < 0 || !buildSlices(problem)) {
+        return;
+    }
+    solution.logScale =
+        buildCompletions(unconstrainedHoles, badSpots, completions_);
+    sweepForward(badSpots);
+    sweepBackward();
+
+    for (int s = 1; s <= sliceCount_; s++) {
+        const Layer &layer = layers_[s];
+        const std::vector<int> &holes = sliceHoles_[s - 1];
+        for (size_t j = 0; j < layer.keys.size(); j++) {
+            const uint32_t mask = uint32_t(layer.keys[j]);
+            const double weight = std::inner_product(layer.forward[j].begin(),
+                                                     layer.forward[j].end(),
+                                                     layer.backward[j].begin(),
+                                                     0.0);
+            // Only states on no complete layout weigh nothing.
+            if (weight == 0.0) {
+                continue;
+            }
+            for (int bit = 0; bit < int(holes.size()); bit++) {
+                if ((mask >> bit) & 1u) {
+                    solution.badWeight[holes[bit]] += weight;
+                    solution.outcomes[holes[bit]] |= Outcomes::bad;
+                } else {
+                    solution.outcomes[holes[bit]] |= Outcomes::safe;
+                }
+            }
+        }
+        solution.iterations += layer.transitions.size();
+        solution.legalIterations += int(layer.keys.size());
+    }
+
+    const Layer &last = layers_[sliceCount_];
+    for (const std::vector<double> &counts : last.forward) {
+        for (int c = 0; c < int(counts.size()); c++) {
+            const double weight = counts[c] * completions_[c];
+            if (weight == 0.0) {
+                continue;
+            }
+            solution.totalWeight += weight;
+            solution.unconstrainedOutcomes |=
+                Outcomes::ofCount(badSpots - c, unconstrainedHoles);
+            if (unconstrainedHoles > 0) {
+                solution.unconstrainedBadWeight +=
+                    weight * (badSpots - c) / unconstrainedHoles;
+            }
+        }
+    }
+}
+
+bool ColumnSweep::buildSlices(const FrontierProblem &problem)
+{
+    const int numFrontier = int(problem.holes.size());
+    sliceHoles_.assign(sliceCount_, std::vector<int>());
+    closingConstraints_.assign(sliceCount_, std::vector<SliceConstraint>());
+    holeSlice_.resize(numFrontier);
+    holeBit_.resize(numFrontier);
+    for (int i = 0; i < numFrontier; i++) {
+        const int cell = problem.holes[i];
+        const int slice = alongX_ ? cell % width_ : cell / width_;
+        holeSlice_[i] = slice;
+        holeBit_[i] = int(sliceHoles_[slice].size());
+        sliceHoles_[slice].push_back(i);
+    }
+    for (size_t c = 0; c < problem.constraintHoles.size(); c++) {
+        const std::vector<int> &holes = problem.constraintHoles[c];
+        if (holes.empty()) {
+            if (problem.maxBadness[c] > 1) {
+                return false;
+            }
+            continue;
+        }
+        int closing = 0;
+        for (int position : holes) {
+            closing = std::max(closing, holeSlice_[position]);
+        }
+        SliceConstraint constraint{problem.maxBadness[c], {0, 0, 0}};
+        for (int position : holes) {
+            constraint.masks[2 - (closing - holeSlice_[position])] |=
+                1u << holeBit_[position];
+        }
+        closingConstraints_[closing].push_back(constraint);
+    }
+    return true;
+}
+
+void ColumnSweep::sweepForward(int badSpots)
+{
+    layers_.resize(sliceCount_ + 1);
+    Layer &first = layers_[0];
+    first.states.clear();
+    first.states.emplace(0, 0);
+    first.keys.assign(1, 0);
+    first.forward.assign(1, std::vector<double>(1, 1.0));
+    first.transitions.clear();
+
+    int frontierHoles = 0;
+    for (int s = 0; s < sliceCount_; s++) {
+        const Layer &previous = layers_[s];
+        Layer &next = layers_[s + 1];
+        next.states.clear();
+        next.keys.clear();
+        next.forward.clear();
+        next.transitions.clear();
+
+        const int holes = int(sliceHoles_[s].size());
+        frontierHoles += holes;
+        const int length = std::min(badSpots, frontierHoles) + 1;
+        for (int i = 0; i < int(previous.keys.size()); i++) {
+            const uint32_t older = uint32_t(previous.keys[i] >> 32);
+            const uint32_t recent = uint32_t(previous.keys[i]);
+            for (uint32_t mask = 0; mask < (1u << holes); mask++) {
+                const int bad = popcount(mask);
+                if (bad > badSpots) {
+                    continue;
+                }
+                bool legal = true;
+                for (const SliceConstraint &constraint :
+                     closingConstraints_[s]) {
+                    const int seen = popcount(older & constraint.masks[0]) +
+                                     popcount(recent & constraint.masks[1]) +
+                                     popcount(mask & constraint.masks[2]);
+                    if (seen != constraint.maxBadness &&
+                        seen + 1 != constraint.maxBadness) {
+                        legal = false;
+                        break;
+                    }
+                }
+                if (!legal) {
+                    continue;
+                }
+                const uint64_t key = (uint64_t(recent) << 32) | mask;
+                auto inserted = next.states.emplace(key, int(next.keys.size()));
+                if (inserted.second) {
+                    next.keys.push_back(key);
+                    next.forward.emplace_back(length, 0.0);
+                }
+                const int j = inserted.first->second;
+                const std::vector<double> &from = previous.forward[i];
+                std::vector<double> &to = next.forward[j];
+                for (int c = 0; c < int(from.size()) && c + bad < length; c++) {
+                    to[c + bad] += from[c];
+                }
+                next.transitions.push_back({i, j, bad});
+            }
+        }
+    }
+}
+
+void ColumnSweep::sweepBackward()
+{
+    Layer &last = layers_[sliceCount_];
+    last.backward.resize(last.keys.size());
+    for (size_t j = 0; j < last.keys.size(); j++) {
+        last.backward[j].assign(completions_.begin(),
+                                completions_.begin() +
+                                    last.forward[j].size());
+    }
+    for (int s = sliceCount_; s > 0; s--) {
+        const Layer &current = layers_[s];
+        Layer &previous = layers_[s - 1];
+        previous.backward.resize(previous.keys.size());
+        for (size_t j = 0; j < previous.keys.size(); j++) {
+            previous.backward[j].assign(previous.forward[j].size(), 0.0);
+        }
+        for (const Transition &transition : current.transitions) {
+            const std::vector<double> &from = current.backward[transition.to];
+            std::vector<double> &to = previous.backward[transition.from];
+            for (int c = 0; c < int(to.size()) &&
+                            c + transition.bad < int(from.size());
+                 c++) {
+                to[c] += from[c + transition.bad];
+            }
+        }
+    }
+}
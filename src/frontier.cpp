@@ -0,0 +1,46 @@
+#include "headers/frontier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+
+// Binomial weights are kept as exact counts until they would come close to
+// overflowing a double; beyond that they are scaled by a common factor.
+const double maxUnscaledLog = 600.0;
+
+double logChoose(int n, int k)
+{
+    return std::lgamma(n + 1.0) - std::lgamma(k + 1.0) -
+           std::lgamma(n - k + 1.0);
+}
+
+} // namespace
+
+double buildCompletions(int unconstrainedHoles,
+                        int badSpots,
+                        std::vector<double> &completions)
+{
+    completions.assign(badSpots + 1, 0.0);
+    const int maxRest = std::min(badSpots, unconstrainedHoles);
+    double logScale = 0.0;
+    for (int rest = 0; rest <= maxRest; rest++) {
+        logScale = std::max(logScale, logChoose(unconstrainedHoles, rest));
+    }
+    if (logScale < maxUnscaledLog) {
+        double binomial = 1.0;
+        for (int rest = 0; rest <= maxRest; rest++) {
+            completions[badSpots - rest] = binomial;
+            binomial *= double(unconstrainedHoles - rest) / (rest + 1);
+        }
+        return 0.0;
+    }
+    for (int rest = 0; rest <= maxRest; rest++) {
+        completions[badSpots - rest] =
+            std::max(std::exp(logChoose(unconstrainedHoles, rest) - logScale),
+                     std::numeric_limits<double>::denorm_min());
+    }
+    return logScale;
+}
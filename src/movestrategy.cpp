@@ -0,0 +1,210 @@
+#include "headers/movestrategy.h"
+
+#include "headers/dugtype.h"
+#include "headers/neighbortable.h"
+#include "headers/rolloutevaluator.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+
+// Short enough for the benchmark to play its games in reasonable time.
+const std::chrono::milliseconds rolloutBudget(25);
+const int clueClasses = 5;
+const double clueValues[clueClasses] = {1.0, 5.0, 20.0, 100.0, 300.0};
+const double rupoorPenalty = 10.0;
+
+// Distribution of the clue a cell would show if safe, over green, blue, red,
+// silver and gold. The bad count of its neighbors is built up one neighbor
+// at a time, taking their probabilities as independent.
+std::array<double, clueClasses>
+clueDistribution(const MoveContext &context,
+                 const NeighborTable &neighbors,
+                 int index)
+{
+    std::array<double, 9> counts{};
+    counts[0] = 1.0;
+    int seen = 0;
+    for (int neighbor : neighbors[index]) {
+        const double p = context.probabilities[neighbor];
+        seen++;
+        for (int c = seen; c > 0; c--) {
+            counts[c] = counts[c] * (1.0 - p) + counts[c - 1] * p;
+        }
+        counts[0] *= 1.0 - p;
+    }
+    std::array<double, clueClasses> classes{};
+    for (int c = 0; c < int(counts.size()); c++) {
+        classes[(c + 1) / 2] += counts[c];
+    }
+    return classes;
+}
+
+// Rupees a cell is expected to pay out if it turns out safe.
+double expectedClueValue(const std::array<double, clueClasses> &classes)
+{
+    double value = 0.0;
+    for (int c = 0; c < clueClasses; c++) {
+        value += classes[c] * clueValues[c];
+    }
+    return value;
+}
+
+template <class Score>
+int highestScoringMove(const MoveContext &context, Score score)
+{
+    int best = -1;
+    double bestScore = 0.0;
+    const int numHoles = int(context.knownBoard.size());
+    for (int i = 0; i < numHoles; i++) {
+        if (context.knownBoard[i] != DugType::DugType::undug) {
+            continue;
+        }
+        const double s = score(i);
+        if (best == -1 || s > bestScore) {
+            best = i;
+            bestScore = s;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+const char *LowestRiskStrategy::name() const
+{
+    return "Lowest risk";
+}
+
+int LowestRiskStrategy::selectMove(const MoveContext &context) const
+{
+    return highestScoringMove(
+        context, [&](int i) { return -context.probabilities[i]; });
+}
+
+const char *RiskNeighborSumStrategy::name() const
+{
+    return "Lowest risk, highest neighbor sum";
+}
+
+int RiskNeighborSumStrategy::selectMove(const MoveContext &context) const
+{
+    int best = -1;
+    double lowestProbability = 1.0;
+    double highestNeighborSum = 0.0;
+    const int numHoles = int(context.knownBoard.size());
+    for (int i = 0; i < numHoles; i++) {
+        if (context.knownBoard[i] != DugType::DugType::undug) {
+            continue;
+        }
+        const double probability = context.probabilities[i];
+        const double neighborSum = context.neighborSums[i];
+        if (best == -1 || probability < lowestProbability ||
+            (probability == lowestProbability &&
+             neighborSum > highestNeighborSum)) {
+            best = i;
+            lowestProbability = probability;
+            highestNeighborSum = neighborSum;
+        }
+    }
+    return best;
+}
+
+const char *ExpectedRupeeStrategy::name() const
+{
+    return "Expected rupees";
+}
+
+int ExpectedRupeeStrategy::selectMove(const MoveContext &context) const
+{
+    // A rupoor costs its penalty, while a bomb ends the game and forfeits
+    // what the remaining safe cells would still have paid out.
+    const int numHoles = int(context.knownBoard.size());
+    const std::shared_ptr<const NeighborTable> neighbors =
+        NeighborTable::forShape(context.params.width, context.params.height);
+    std::vector<double> safeValues(numHoles, 0.0);
+    double remaining = 0.0;
+    for (int i = 0; i < numHoles; i++) {
+        if (context.knownBoard[i] == DugType::DugType::undug) {
+            safeValues[i] = (1.0 - context.probabilities[i]) *
+                            expectedClueValue(
+                                clueDistribution(context, *neighbors, i));
+            remaining += safeValues[i];
+        }
+    }
+    const int bad = context.params.bombs + context.params.rupoors;
+    const double bombShare =
+        bad > 0 ? double(context.params.bombs) / bad : 0.0;
+    return highestScoringMove(context, [&](int i) {
+        const double probability = context.probabilities[i];
+        return safeValues[i] -
+               probability * (1.0 - bombShare) * rupoorPenalty -
+               probability * bombShare * (remaining - safeValues[i]);
+    });
+}
+
+const char *InformationGainStrategy::name() const
+{
+    return "Information gain";
+}
+
+int InformationGainStrategy::selectMove(const MoveContext &context) const
+{
+    // The expected information gained is the Shannon entropy of the clue
+    // the cell would reveal.
+    const std::shared_ptr<const NeighborTable> neighbors =
+        NeighborTable::forShape(context.params.width, context.params.height);
+    return highestScoringMove(context, [&](int i) {
+        const std::array<double, clueClasses> classes =
+            clueDistribution(context, *neighbors, i);
+        double entropy = 0.0;
+        for (double probability : classes) {
+            if (probability > 0.0) {
+                entropy -= probability * std::log2(probability);
+            }
+        }
+        return (1.0 - context.probabilities[i]) * (1.0 + entropy);
+    });
+}
+
+RolloutStrategy::RolloutStrategy(const ProblemParameters &params)
+    : evaluator_(std::make_unique<RolloutEvaluator>(params))
+{
+    evaluator_->setTimeBudget(rolloutBudget);
+}
+
+RolloutStrategy::~RolloutStrategy() = default;
+
+const char *RolloutStrategy::name() const
+{
+    return "Monte Carlo rollouts";
+}
+
+int RolloutStrategy::selectMove(const MoveContext &context) const
+{
+    const int safest = highestScoringMove(
+        context, [&](int i) { return -context.probabilities[i]; });
+    if (safest == -1 || context.probabilities[safest] == 0.0) {
+        return safest;
+    }
+    evaluator_->evaluate(context.knownBoard);
+    const int best = evaluator_->bestMove();
+    return best != -1 ? best : safest;
+}
+
+std::vector<std::unique_ptr<MoveStrategy>>
+createMoveStrategies(const ProblemParameters &params, bool withRollouts)
+{
+    std::vector<std::unique_ptr<MoveStrategy>> strategies;
+    strategies.push_back(std::make_unique<LowestRiskStrategy>());
+    strategies.push_back(std::make_unique<RiskNeighborSumStrategy>());
+    strategies.push_back(std::make_unique<ExpectedRupeeStrategy>());
+    strategies.push_back(std::make_unique<InformationGainStrategy>());
+    if (withRollouts) {
+        strategies.push_back(std::make_unique<RolloutStrategy>(params));
+    }
+    return strategies;
+}
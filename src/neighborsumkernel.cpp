@@ -0,0 +1,66 @@
+#include "headers/neighborsumkernel.h"
+
+#include "headers/problemparameters.h"
+
+NeighborSumKernel::NeighborSumKernel(const ProblemParameters &params)
+    : width_(params.width),
+      height_(params.height),
+      rowSums_(params.width * params.height, 0.0),
+      sums_(params.width * params.height, 0.0)
+{
+}
+
+void NeighborSumKernel::compute(const std::vector<double> &probabilities)
+{
+    boxSum(probabilities, rowSums_, sums_);
+}
+
+const std::vector<double> &NeighborSumKernel::sums() const
+{
+    return sums_;
+}
+
+void NeighborSumKernel::boxSum(const std::vector<double> &values,
+                               std::vector<double> &rowSums,
+                               std::vector<double> &sums)
+{
+    const double *in = values.data();
+    double *row = rowSums.data();
+    double *out = sums.data();
+    const int w = width_;
+
+    for (int y = 0; y < height_; y++) {
+        const double *src = in + y * w;
+        double *dst = row + y * w;
+        if (w == 1) {
+            dst[0] = src[0];
+            continue;
+        }
+        dst[0] = src[0] + src[1];
+        for (int x = 1; x < w - 1; x++) {
+            dst[x] = src[x - 1] + src[x] + src[x + 1];
+        }
+        dst[w - 1] = src[w - 2] + src[w - 1];
+    }
+
+    for (int y = 0; y < height_; y++) {
+        const double *above = y > 0 ? row + (y - 1) * w : nullptr;
+        const double *below = y < height_ - 1 ? row + (y + 1) * w : nullptr;
+        const double *centre = row + y * w;
+        const double *self = in + y * w;
+        double *dst = out + y * w;
+        for (int x = 0; x < w; x++) {
+            dst[x] = centre[x] - self[x];
+        }
+        if (above != nullptr) {
+            for (int x = 0; x < w; x++) {
+                dst[x] += above[x];
+            }
+        }
+        if (below != nullptr) {
+            for (int x = 0; x < w; x++) {
+                dst[x] += below[x];
+            }
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#include "headers/neighbortable.h"
+
+#include <map>
+#include <mutex>
+#include <utility>
+
+NeighborTable::NeighborTable(int width, int height)
+{
+    offsets_.reserve(width * height + 1);
+    indices_.reserve(width * height * 8);
+    offsets_.push_back(0);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            for (int filterY = y - 1; filterY < y + 2; filterY++) {
+                if (filterY < 0 || filterY >= height) {
+                    continue;
+                }
+                for (int filterX = x - 1; filterX < x + 2; filterX++) {
+                    if (filterX >= 0 && filterX < width &&
+                        (filterX != x || filterY != y)) {
+                        indices_.push_back(filterY * width + filterX);
+                    }
+                }
+            }
+            offsets_.push_back(int(indices_.size()));
+        }
+    }
+    reverseSlots_.resize(indices_.size());
+    for (int cell = 0; cell < width * height; cell++) {
+        for (int k = offsets_[cell]; k < offsets_[cell + 1]; k++) {
+            const int neighbor = indices_[k];
+            for (int j = offsets_[neighbor]; j < offsets_[neighbor + 1]; j++) {
+                if (indices_[j] == cell) {
+                    reverseSlots_[k] = j - offsets_[neighbor];
+                }
+            }
+        }
+    }
+}
+
+std::shared_ptr<const NeighborTable> NeighborTable::forShape(int width,
+                                                             int height)
+{
+    static std::mutex mutex;
+    static std::map<std::pair<int, int>, std::weak_ptr<const NeighborTable>>
+        tables;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &entry = tables[{width, height}];
+    std::shared_ptr<const NeighborTable> table = entry.lock();
+    if (table == nullptr) {
+        table = std::make_shared<const NeighborTable>(width, height);
+        entry = table;
+    }
+    return table;
+}
@@ -0,0 +1,309 @@
+#include "headers/openingbook.h"
+
+#include "headers/presetsolver.h"
+#include "headers/solver.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <set>
+#include <tuple>
+
+namespace
+{
+
+const DugType::DugType revealedTypes[] = {DugType::rupoor,
+                                          DugType::green,
+                                          DugType::blue,
+                                          DugType::red,
+                                          DugType::silver,
+                                          DugType::gold};
+
+// Keeps uncertain probabilities strictly inside (0, 1) once narrowed, so
+// that they are not read back as certain.
+float narrow(double probability)
+{
+    if (probability <= 0.0 || probability >= 1.0) {
+        return float(probability);
+    }
+    return std::clamp(float(probability),
+                      std::numeric_limits<float>::min(),
+                      std::nextafter(1.0f, 0.0f));
+}
+
+template <class T> bool readArray(QIODevice &file, std::vector<T> &values)
+{
+    const qint64 bytes = qint64(values.size() * sizeof(T));
+    return file.read(reinterpret_cast<char *>(values.data()), bytes) == bytes;
+}
+
+template <class T>
+bool writeArray(QIODevice &file, const std::vector<T> &values)
+{
+    const qint64 bytes = qint64(values.size() * sizeof(T));
+    return file.write(reinterpret_cast<const char *>(values.data()), bytes) ==
+           bytes;
+}
+
+} // namespace
+
+OpeningBook::OpeningBook(const ProblemParameters &params, int depth)
+    : params_(params), numHoles_(params.width * params.height), depth_(depth)
+{
+}
+
+std::shared_ptr<const OpeningBook>
+OpeningBook::forParameters(const ProblemParameters &params)
+{
+    if (!hasPresetSolver(params)) {
+        return nullptr;
+    }
+    static std::mutex mutex;
+    static std::map<std::tuple<int, int, int, int>,
+                    std::weak_ptr<const OpeningBook>>
+        books;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &entry =
+        books[{params.width, params.height, params.bombs, params.rupoors}];
+    std::shared_ptr<const OpeningBook> book = entry.lock();
+    if (book == nullptr) {
+        auto created = std::make_shared<OpeningBook>(params, defaultDepth);
+        created->path_ = defaultPath(params);
+        book = created;
+        entry = book;
+    }
+    return book;
+}
+
+QString OpeningBook::defaultPath(const ProblemParameters &params)
+{
+    const QString directory =
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    return QString("%1/openings-%2x%3-%4-%5.book")
+        .arg(directory)
+        .arg(params.width)
+        .arg(params.height)
+        .arg(params.bombs)
+        .arg(params.rupoors);
+}
+
+// Breadth first over the number of dug cells. Each position is solved once
+// per symmetry class; a child digs one undug cell as any type its
+// probability allows, and children no layout agrees with are dropped.
+void OpeningBook::generate()
+{
+    const std::vector<std::vector<int>> symmetries =
+        TranspositionCache::symmetries(params_.width, params_.height);
+    Solver solver(params_);
+    solver.setLogging(false);
+    TranspositionCache::Key key;
+
+    std::vector<uint64_t> hashes;
+    std::vector<double> totalWeights;
+    std::vector<Statistics> statistics;
+    std::vector<int8_t> boards;
+    std::vector<float> probabilities;
+    std::set<std::vector<DugType::DugType>> seen;
+    std::vector<std::vector<DugType::DugType>> level(
+        1, std::vector<DugType::DugType>(numHoles_, DugType::undug));
+    std::vector<std::vector<DugType::DugType>> next;
+    std::vector<DugType::DugType> child;
+    for (int dug = 0; dug <= depth_ && !level.empty(); dug++) {
+        next.clear();
+        for (const std::vector<DugType::DugType> &board : level) {
+            solver.loadBoard(board.data());
+            solver.partitionCalculate();
+            const double totalWeight = solver.getTotalNumConfigurations();
+            if (!(totalWeight > 0.0)) {
+                continue;
+            }
+            const std::vector<double> &solved = solver.getProbabilityArray();
+            const int symmetry = TranspositionCache::makeKey(
+                params_, symmetries, board, key);
+            hashes.push_back(key.hash);
+            totalWeights.push_back(totalWeight);
+            statistics.push_back({solver.getIterations(),
+                                  solver.getLegalIterations(),
+                                  solver.getPartitions(),
+                                  solver.getSunkenPartitions(),
+                                  solver.getConstrainedHoles(),
+                                  solver.getDeducedHoles(),
+                                  0});
+            boards.insert(boards.end(), key.board.begin(), key.board.end());
+            probabilities.resize(probabilities.size() + numHoles_);
+            float *canonical = &probabilities[probabilities.size() - numHoles_];
+            for (int i = 0; i < numHoles_; i++) {
+                canonical[symmetries[symmetry][i]] = narrow(solved[i]);
+            }
+
+            if (dug == depth_) {
+                continue;
+            }
+            for (int i = 0; i < numHoles_; i++) {
+                if (board[i] != DugType::undug) {
+                    continue;
+                }
+                for (DugType::DugType type : revealedTypes) {
+                    const bool possible = type == DugType::rupoor
+                                              ? params_.rupoors > 0 &&
+                                                    solved[i] > 0.0
+                                              : solved[i] < 1.0;
+                    if (!possible) {
+                        continue;
+                    }
+                    child = board;
+                    child[i] = type;
+                    TranspositionCache::makeKey(
+                        params_, symmetries, child, key);
+                    if (seen.insert(key.board).second) {
+                        next.push_back(key.board);
+                    }
+                }
+            }
+        }
+        level.swap(next);
+    }
+
+    std::vector<int> order(hashes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return hashes[a] < hashes[b];
+    });
+    hashes_.resize(order.size());
+    totalWeights_.resize(order.size());
+    statistics_.resize(order.size());
+    boards_.resize(order.size() * numHoles_);
+    probabilities_.resize(order.size() * numHoles_);
+    for (size_t e = 0; e < order.size(); e++) {
+        const int from = order[e];
+        hashes_[e] = hashes[from];
+        totalWeights_[e] = totalWeights[from];
+        statistics_[e] = statistics[from];
+        std::copy_n(
+            &boards[from * numHoles_], numHoles_, &boards_[e * numHoles_]);
+        std::copy_n(&probabilities[from * numHoles_],
+                    numHoles_,
+                    &probabilities_[e * numHoles_]);
+    }
+}
+
+bool OpeningBook::load(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    FileHeader stored;
+    if (file.read(reinterpret_cast<char *>(&stored), sizeof(FileHeader)) !=
+        qint64(sizeof(FileHeader))) {
+        return false;
+    }
+    FileHeader expected = header();
+    expected.count = stored.count;
+    if (std::memcmp(&stored, &expected, sizeof(FileHeader)) != 0) {
+        return false;
+    }
+    hashes_.resize(stored.count);
+    totalWeights_.resize(stored.count);
+    statistics_.resize(stored.count);
+    boards_.resize(size_t(stored.count) * numHoles_);
+    probabilities_.resize(size_t(stored.count) * numHoles_);
+    if (!readArray(file, hashes_) || !readArray(file, totalWeights_) ||
+        !readArray(file, statistics_) || !readArray(file, boards_) ||
+        !readArray(file, probabilities_)) {
+        hashes_.clear();
+        totalWeights_.clear();
+        statistics_.clear();
+        boards_.clear();
+        probabilities_.clear();
+        return false;
+    }
+    return true;
+}
+
+// Written beside the old file and renamed into place, so that a reader never
+// sees a partly written book.
+bool OpeningBook::save(const QString &path) const
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    const FileHeader stored = header();
+    return file.write(reinterpret_cast<const char *>(&stored),
+                      sizeof(FileHeader)) == qint64(sizeof(FileHeader)) &&
+           writeArray(file, hashes_) && writeArray(file, totalWeights_) &&
+           writeArray(file, statistics_) && writeArray(file, boards_) &&
+           writeArray(file, probabilities_) && file.commit();
+}
+
+int OpeningBook::size() const
+{
+    return int(hashes_.size());
+}
+
+bool OpeningBook::find(const TranspositionCache::Key &key,
+                       TranspositionCache::Position &position) const
+{
+    if (key.width != params_.width || key.height != params_.height ||
+        key.bombs != params_.bombs || key.rupoors != params_.rupoors) {
+        return false;
+    }
+    if (!path_.isEmpty()) {
+        // Shared books are only ever created non-const, and nothing reads
+        // the entries before the first lookup has filled them in.
+        std::call_once(prepared_,
+                       [this] { const_cast<OpeningBook *>(this)->prepare(); });
+    }
+    const auto range =
+        std::equal_range(hashes_.begin(), hashes_.end(), key.hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        const size_t entry = size_t(it - hashes_.begin());
+        const int8_t *board = &boards_[entry * numHoles_];
+        if (!std::equal(board, board + numHoles_, key.board.begin())) {
+            continue;
+        }
+        const float *stored = &probabilities_[entry * numHoles_];
+        position.probabilities.assign(stored, stored + numHoles_);
+        position.totalWeight = totalWeights_[entry];
+        position.logScale = 0.0;
+        const Statistics &statistics = statistics_[entry];
+        position.iterations = statistics.iterations;
+        position.legalIterations = statistics.legalIterations;
+        position.partitions = statistics.partitions;
+        position.sunkenPartitions = statistics.sunkenPartitions;
+        position.constrainedHoles = statistics.constrainedHoles;
+        position.deducedHoles = statistics.deducedHoles;
+        return true;
+    }
+    return false;
+}
+
+void OpeningBook::prepare()
+{
+    if (!load(path_)) {
+        generate();
+        save(path_);
+    }
+}
+
+OpeningBook::FileHeader OpeningBook::header() const
+{
+    return {magic,
+            version,
+            uint32_t(params_.width),
+            uint32_t(params_.height),
+            uint32_t(params_.bombs),
+            uint32_t(params_.rupoors),
+            uint32_t(depth_),
+            uint32_t(hashes_.size())};
+}
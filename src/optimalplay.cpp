@@ -0,0 +1,308 @@
+#include "headers/optimalplay.h"
+
+#include "headers/neighbortable.h"
+#include "headers/transpositioncache.h"
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+
+struct SafeType {
+    DugType::DugType type;
+    int minimumBadNeighbors;
+};
+
+const SafeType safeTypes[] = {{DugType::green, 0},
+                              {DugType::blue, 1},
+                              {DugType::red, 3},
+                              {DugType::silver, 5},
+                              {DugType::gold, 7}};
+
+// Three bits per cell; bombs end the game, so they never reach a key.
+uint64_t cellCode(DugType::DugType type)
+{
+    return type < 0 ? uint64_t(type + 3) : uint64_t(3 + type / 2);
+}
+
+} // namespace
+
+OptimalPlay::Search::Search(const ProblemParameters &params)
+    : solver(params),
+      board(params.width * params.height),
+      probabilities(params.width * params.height + 1)
+{
+    solver.setLogging(false);
+}
+
+OptimalPlay::OptimalPlay(const ProblemParameters &params, int threads)
+    : params_(params),
+      numHoles_(params.width * params.height),
+      threads_(threads > 0
+                   ? threads
+                   : std::max(1, int(std::thread::hardware_concurrency()))),
+      symmetries_(TranspositionCache::symmetries(params.width, params.height))
+{
+    const std::shared_ptr<const NeighborTable> neighbors =
+        NeighborTable::forShape(params.width, params.height);
+    for (int i = 0; i < numHoles_; i++) {
+        neighborCounts_.push_back(int((*neighbors)[i].size()));
+    }
+}
+
+bool OptimalPlay::isFeasible(const ProblemParameters &params)
+{
+    const int numHoles = params.width * params.height;
+    return numHoles > 0 && numHoles <= maxHoles &&
+           params.bombs + params.rupoors < numHoles;
+}
+
+double OptimalPlay::solve(const std::vector<DugType::DugType> &position)
+{
+    moveValues_.clear();
+    rootMoves_.clear();
+    int undug = 0;
+    int hiddenRupoors = params_.rupoors;
+    for (DugType::DugType type : position) {
+        if (type == DugType::bomb) {
+            return 0.0;
+        }
+        undug += type == DugType::undug ? 1 : 0;
+        hiddenRupoors -= type == DugType::rupoor ? 1 : 0;
+    }
+
+    Search root(params_);
+    root.board = position;
+    root.solver.loadBoard(position.data());
+    root.solver.partitionCalculate();
+    if (!(root.solver.getTotalNumConfigurations() > 0.0) ||
+        hiddenRupoors < 0) {
+        return 0.0;
+    }
+    if (undug == params_.bombs + hiddenRupoors) {
+        return 1.0;
+    }
+    const std::vector<double> probabilities =
+        root.solver.getProbabilityArray();
+    // Moves mapped onto each other by a symmetry of the position are
+    // searched once; a bomb marks the move, as no searched board holds one.
+    std::vector<int> sameAs;
+    std::unordered_map<uint64_t, int> moveKeys;
+    for (int i = 0; i < numHoles_; i++) {
+        if (position[i] != DugType::undug || probabilities[i] >= 1.0) {
+            continue;
+        }
+        root.board[i] = DugType::bomb;
+        const auto inserted =
+            moveKeys.emplace(canonicalKey(root.board), int(rootMoves_.size()));
+        root.board[i] = DugType::undug;
+        sameAs.push_back(inserted.first->second);
+        if (inserted.second) {
+            rootMoves_.push_back({i, 0.0});
+        }
+    }
+
+    nextMove_ = 0;
+    const int threads = std::min(threads_, int(rootMoves_.size()));
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++) {
+        workers.emplace_back([&] {
+            Search search(params_);
+            search.board = position;
+            searchRootMoves(search, undug, hiddenRupoors, probabilities);
+        });
+    }
+    searchRootMoves(root, undug, hiddenRupoors, probabilities);
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    double best = 0.0;
+    int move = 0;
+    for (int i = 0; i < numHoles_; i++) {
+        if (position[i] == DugType::undug && probabilities[i] < 1.0) {
+            const double value = rootMoves_[sameAs[move++]].winProbability;
+            moveValues_.push_back({i, value});
+            best = std::max(best, value);
+        }
+    }
+    return best;
+}
+
+int OptimalPlay::bestMove() const
+{
+    const MoveValue *best = nullptr;
+    for (const MoveValue &move : moveValues_) {
+        if (best == nullptr || move.winProbability > best->winProbability) {
+            best = &move;
+        }
+    }
+    return best != nullptr ? best->cell : -1;
+}
+
+const std::vector<OptimalPlay::MoveValue> &OptimalPlay::moveValues() const
+{
+    return moveValues_;
+}
+
+size_t OptimalPlay::positions() const
+{
+    size_t count = 0;
+    for (const Shard &shard : shards_) {
+        count += shard.outcomes.size();
+    }
+    return count;
+}
+
+uint64_t
+OptimalPlay::canonicalKey(const std::vector<DugType::DugType> &board) const
+{
+    uint64_t best = ~uint64_t(0);
+    for (const std::vector<int> &symmetry : symmetries_) {
+        uint64_t key = 0;
+        for (int i = 0; i < numHoles_; i++) {
+            key = key << 3 | cellCode(board[symmetry[i]]);
+        }
+        best = std::min(best, key);
+    }
+    return best;
+}
+
+bool OptimalPlay::find(uint64_t key, Outcome &outcome)
+{
+    Shard &shard = shards_[key % shardCount];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto found = shard.outcomes.find(key);
+    if (found == shard.outcomes.end()) {
+        return false;
+    }
+    outcome = found->second;
+    return true;
+}
+
+void OptimalPlay::store(uint64_t key, const Outcome &outcome)
+{
+    Shard &shard = shards_[key % shardCount];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.outcomes.emplace(key, outcome);
+}
+
+// The weight of the board in search.board, and its value under perfect
+// play.
+OptimalPlay::Outcome
+OptimalPlay::solveBoard(Search &search, int undug, int hiddenRupoors)
+{
+    const uint64_t key = canonicalKey(search.board);
+    Outcome outcome;
+    if (find(key, outcome)) {
+        return outcome;
+    }
+    search.solver.loadBoard(search.board.data());
+    search.solver.partitionCalculate();
+    outcome.weight = search.solver.getTotalNumConfigurations();
+    if (!(outcome.weight > 0.0)) {
+        store(key, outcome);
+        return outcome;
+    }
+    if (undug == params_.bombs + hiddenRupoors) {
+        outcome.winProbability = 1.0;
+        store(key, outcome);
+        return outcome;
+    }
+
+    std::vector<double> &probabilities =
+        search.probabilities[numHoles_ - undug];
+    probabilities = search.solver.getProbabilityArray();
+    std::vector<int> moves;
+    for (int i = 0; i < numHoles_; i++) {
+        if (search.board[i] != DugType::undug || probabilities[i] >= 1.0) {
+            continue;
+        }
+        if (probabilities[i] <= 0.0) {
+            moves.assign(1, i);
+            break;
+        }
+        moves.push_back(i);
+    }
+    std::stable_sort(moves.begin(), moves.end(), [&](int a, int b) {
+        return probabilities[a] < probabilities[b];
+    });
+
+    // A dig loses at most when it finds a bomb, which bounds its value.
+    const double bombShare =
+        params_.bombs > 0
+            ? double(params_.bombs) / (params_.bombs + hiddenRupoors)
+            : 0.0;
+    for (int cell : moves) {
+        const double bound = 1.0 - probabilities[cell] * bombShare;
+        if (bound <= outcome.winProbability) {
+            break;
+        }
+        outcome.winProbability =
+            std::max(outcome.winProbability,
+                     moveValue(search,
+                               cell,
+                               probabilities[cell],
+                               undug,
+                               hiddenRupoors));
+        if (outcome.winProbability >= 1.0) {
+            break;
+        }
+    }
+    store(key, outcome);
+    return outcome;
+}
+
+// Safe outcomes are weighed by the configurations agreeing with them, and a
+// bad one is a rupoor in proportion to the rupoors still hidden.
+double OptimalPlay::moveValue(Search &search,
+                              int cell,
+                              double badProbability,
+                              int undug,
+                              int hiddenRupoors)
+{
+    double winProbability = 0.0;
+    if (badProbability < 1.0) {
+        double totalWeight = 0.0;
+        double winningWeight = 0.0;
+        for (const SafeType &safe : safeTypes) {
+            if (safe.minimumBadNeighbors > neighborCounts_[cell]) {
+                break;
+            }
+            search.board[cell] = safe.type;
+            const Outcome outcome =
+                solveBoard(search, undug - 1, hiddenRupoors);
+            totalWeight += outcome.weight;
+            winningWeight += outcome.weight * outcome.winProbability;
+        }
+        if (totalWeight > 0.0) {
+            winProbability +=
+                (1.0 - badProbability) * winningWeight / totalWeight;
+        }
+    }
+    if (badProbability > 0.0 && hiddenRupoors > 0) {
+        search.board[cell] = DugType::rupoor;
+        const Outcome outcome =
+            solveBoard(search, undug - 1, hiddenRupoors - 1);
+        winProbability += badProbability * hiddenRupoors /
+                          (params_.bombs + hiddenRupoors) *
+                          outcome.winProbability;
+    }
+    search.board[cell] = DugType::undug;
+    return winProbability;
+}
+
+void OptimalPlay::searchRootMoves(Search &search,
+                                  int undug,
+                                  int hiddenRupoors,
+                                  const std::vector<double> &probabilities)
+{
+    for (int m = nextMove_++; m < int(rootMoves_.size()); m = nextMove_++) {
+        MoveValue &move = rootMoves_[m];
+        move.winProbability = moveValue(search,
+                                        move.cell,
+                                        probabilities[move.cell],
+                                        undug,
+                                        hiddenRupoors);
+    }
+}
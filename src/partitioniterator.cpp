@@ -5,22 +5,35 @@
 #include <QList>
 #include <QSetIterator>
 #include <algorithm>
+#include <unordered_set>
 
-PartitionIterator::PartitionIterator(std::vector<Partition *> *partitionList,
-                                     std::vector<bool> &badSpots,
-                                     std::vector<Partition *> *sunkenPartitions,
-                                     int numBadSpots)
+namespace
+{
+
+bool isSatisfied(const Constraint &constraint)
+{
+    return constraint.badness == constraint.maxBadness ||
+           constraint.badness + 1 == constraint.maxBadness;
+}
+
+} // namespace
+
+template <typename Weight>
+PartitionIterator<Weight>::PartitionIterator(
+    std::vector<Partition *> *partitionList,
+    std::vector<bool> &badSpots,
+    std::vector<Partition *> *sunkenPartitions,
+    const std::vector<Constraint *> &constraintList,
+    int numBadSpots)
     : partitionList{*partitionList}, badSpots{badSpots}
 {
-    weight = 1.0;
+    weight = Weight::one();
     Constraint *constraint;
     Partition *partition;
-    int hole;
     int sunkenBadness = 0;
     int maxAmount;
     int minAmount;
-    started = false;
-    indexArrayLength = numBadSpots;
+    int unplaced = numBadSpots;
     int sumMax = 0;
     int sumMin = 0;
     bool unconstrainedPartition =
@@ -50,7 +63,10 @@ PartitionIterator::PartitionIterator(std::vector<Partition *> *partitionList,
         sumMin += minAmount;
         sumMax += maxAmount;
         partition->badness = minAmount;
-        indexArrayLength -= minAmount;
+        unplaced -= minAmount;
+        Weight::multiplyBinomial(weight,
+                                 int(partition->holes.size()),
+                                 int(partition->badness));
         if (maxAmount == minAmount) {
             sunkenBadness += partition->badness;
             partitionList->erase(std::remove(partitionList->begin(),
@@ -60,7 +76,6 @@ PartitionIterator::PartitionIterator(std::vector<Partition *> *partitionList,
             sunkenPartitions->push_back(partition);
             continue;
         }
-        weight *= choose(int(partition->holes.size()), int(partition->badness));
         minAmountsPerPartition.insert(minAmountsPerPartition.begin(),
                                       minAmount);
         maxAmountsPerPartition.insert(maxAmountsPerPartition.begin(),
@@ -72,7 +87,7 @@ PartitionIterator::PartitionIterator(std::vector<Partition *> *partitionList,
         maxAmount =
             std::min(numBadSpots - sumMin, int(partition->holes.size()));
         minAmount = std::max(numBadSpots - sumMax, 0);
-        indexArrayLength -= minAmount;
+        unplaced -= minAmount;
 
         partition->badness = minAmount;
         for (int j = 0; j < minAmount; j++) {
@@ -81,6 +96,9 @@ PartitionIterator::PartitionIterator(std::vector<Partition *> *partitionList,
         for (int j = minAmount; j < int(partition->holes.size()); j++) {
             badSpots[partition->holes.at(j)] = false;
         }
+        Weight::multiplyBinomial(weight,
+                                 int(partition->holes.size()),
+                                 int(partition->badness));
         if (maxAmount == minAmount) {
             sunkenBadness += partition->badness;
             partitionList->erase(std::remove(partitionList->begin(),
@@ -94,124 +112,154 @@ PartitionIterator::PartitionIterator(std::vector<Partition *> *partitionList,
                                           minAmount);
             maxAmountsPerPartition.insert(maxAmountsPerPartition.begin(),
                                           maxAmount);
-            weight *=
-                choose(int(partition->holes.size()), int(partition->badness));
         }
     }
     listLength = int(partitionList->size());
-    indexArray.resize(indexArrayLength);
-    int k = 0;
-    int index = 0;
-    while (k < indexArrayLength) {
-        partition = partitionList->at(index);
-        if (partition->badness < maxAmountsPerPartition.at(index)) {
-            indexArray[k] = index;
-            weight /= choose(int(partition->holes.size()), partition->badness);
-            hole = partition->holes.at(partition->badness);
-            badSpots[hole] = true;
-            partition->badness++;
-            weight *= choose(int(partition->holes.size()), partition->badness);
-            k++;
-        } else {
-            index++;
-        }
+    capacityBelow.resize(listLength + 1);
+    capacityBelow[0] = 0;
+    feasible = unplaced >= 0;
+    for (int i = 0; i < listLength; i++) {
+        const int capacity =
+            maxAmountsPerPartition[i] - minAmountsPerPartition[i];
+        feasible = feasible && capacity >= 0;
+        capacityBelow[i + 1] = capacityBelow[i] + capacity;
     }
-}
+    feasible = feasible && unplaced <= capacityBelow[listLength];
 
-bool PartitionIterator::hasNext()
-{
-    Partition *partition;
-    Partition *givingPartition;
-    Partition *receivingPartition;
-    int hole;
-    int badnessAccumulator = 0;
-    int givingIndex;
-    int receivingIndex;
-    for (int i = listLength - 1; i >= 0; i--) {
-        partition = partitionList[i];
-        badnessAccumulator += partition->badness - minAmountsPerPartition.at(i);
-        if (partition->badness < maxAmountsPerPartition.at(i) &&
-            badnessAccumulator < indexArrayLength) {
-
-            givingIndex = indexArrayLength - badnessAccumulator - 1;
-            givingPartition = partitionList[indexArray[givingIndex]];
-            weight /= choose(int(givingPartition->holes.size()),
-                             givingPartition->badness);
-            givingPartition->badness--;
-            weight *= choose(int(givingPartition->holes.size()),
-                             givingPartition->badness);
-            hole = givingPartition->holes.at(givingPartition->badness);
-            badSpots[hole] = false;
-
-            receivingIndex = indexArray[givingIndex] + 1;
-
-            receivingPartition = partitionList[receivingIndex];
-            hole = receivingPartition->holes.at(receivingPartition->badness);
-            badSpots[hole] = true;
-            weight /= choose(int(receivingPartition->holes.size()),
-                             receivingPartition->badness);
-            receivingPartition->badness++;
-            weight *= choose(int(receivingPartition->holes.size()),
-                             receivingPartition->badness);
-            indexArray[givingIndex] = receivingIndex;
-
-            int index = givingIndex + 1;
-            int partitionIndex = receivingIndex;
-            receivingPartition = partitionList[partitionIndex];
-
-            while (index < indexArrayLength && partitionIndex < listLength) {
-                givingPartition = partitionList[indexArray[index]];
-                receivingPartition = partitionList[partitionIndex];
-                if (receivingPartition->badness ==
-                    maxAmountsPerPartition.at(partitionIndex)) {
-                    partitionIndex++;
-                    continue;
-                }
-                if (givingPartition != receivingPartition) {
-                    weight /= choose(int(givingPartition->holes.size()),
-                                     givingPartition->badness);
-                    givingPartition->badness--;
-                    weight *= choose(int(givingPartition->holes.size()),
-                                     givingPartition->badness);
-                    hole = givingPartition->holes.at(givingPartition->badness);
-                    badSpots[hole] = false;
-
-                    hole = receivingPartition->holes.at(
-                        receivingPartition->badness);
-                    badSpots[hole] = true;
-                    weight /= choose(int(receivingPartition->holes.size()),
-                                     receivingPartition->badness);
-                    receivingPartition->badness++;
-                    weight *= choose(int(receivingPartition->holes.size()),
-                                     receivingPartition->badness);
-                    indexArray[index] = partitionIndex;
-                }
-                index++;
+    std::unordered_set<Constraint *> active(constraintList.begin(),
+                                            constraintList.end());
+    partitionConstraints.resize(listLength);
+    for (int i = 0; i < listLength; i++) {
+        for (Constraint *c : partitionList->at(i)->constraints) {
+            if (active.count(c)) {
+                partitionConstraints[i].push_back(c);
             }
-            return true;
         }
+    }
+    unsatisfiedConstraints = 0;
+    for (Constraint *c : constraintList) {
+        c->badness = 0;
+        for (int constrainedHole : c->holes) {
+            if (badSpots[constrainedHole]) {
+                c->badness++;
+            }
+        }
+        if (!isSatisfied(*c)) {
+            unsatisfiedConstraints++;
+        }
+    }
 
-        if (badnessAccumulator == indexArrayLength) {
-            return false;
+    remaining.resize(listLength);
+    reversed.resize(listLength);
+    if (feasible && listLength > 0) {
+        remaining[listLength - 1] = unplaced;
+        reversed[listLength - 1] = false;
+        resetBelow(listLength - 1);
+    }
+}
+
+template <typename Weight>
+bool PartitionIterator<Weight>::hasNext()
+{
+    if (!feasible) {
+        return false;
+    }
+    for (int level = 1; level < listLength; level++) {
+        if (!reversed[level] && offset(level) < highestOffset(level)) {
+            moveBadSpot(level, 1);
+        } else if (reversed[level] && offset(level) > lowestOffset(level)) {
+            moveBadSpot(level, -1);
+        } else {
+            continue;
         }
+        reversed[level - 1] = reversed[level] != (offset(level) % 2 == 1);
+        remaining[level - 1] = remaining[level] - offset(level);
+        resetBelow(level - 1);
+        return true;
     }
     return false;
 }
 
-double PartitionIterator::iterate()
+template <typename Weight>
+const typename PartitionIterator<Weight>::WeightValue &
+PartitionIterator<Weight>::iterate() const
 {
     return weight;
 }
 
-double PartitionIterator::choose(int n, int k)
+template <typename Weight>
+bool PartitionIterator<Weight>::isLegal() const
+{
+    return feasible && unsatisfiedConstraints == 0;
+}
+
+template <typename Weight>
+int PartitionIterator<Weight>::offset(int level) const
 {
-    if (k > n) {
-        return 0.0;
+    return partitionList[level]->badness - minAmountsPerPartition[level];
+}
+
+template <typename Weight>
+int PartitionIterator<Weight>::lowestOffset(int level) const
+{
+    return std::max(0, remaining[level] - capacityBelow[level]);
+}
+
+template <typename Weight>
+int PartitionIterator<Weight>::highestOffset(int level) const
+{
+    return std::min(maxAmountsPerPartition[level] -
+                        minAmountsPerPartition[level],
+                    remaining[level]);
+}
+
+template <typename Weight>
+void PartitionIterator<Weight>::moveBadSpot(int level, int direction)
+{
+    Partition *partition = partitionList[level];
+    const int size = int(partition->holes.size());
+    if (direction > 0) {
+        Weight::multiply(
+            weight, size - partition->badness, partition->badness + 1);
+        badSpots[partition->holes[partition->badness]] = true;
+        partition->badness++;
+    } else {
+        Weight::multiply(
+            weight, partition->badness, size - partition->badness + 1);
+        partition->badness--;
+        badSpots[partition->holes[partition->badness]] = false;
+    }
+    for (Constraint *constraint : partitionConstraints[level]) {
+        const bool wasSatisfied = isSatisfied(*constraint);
+        constraint->badness += direction;
+        unsatisfiedConstraints +=
+            int(wasSatisfied) - int(isSatisfied(*constraint));
     }
-    double r = 1.0;
-    for (int d = 1; d <= k; ++d) {
-        r *= n--;
-        r /= d;
+}
+
+template <typename Weight>
+void PartitionIterator<Weight>::resetBelow(int level)
+{
+    // Moves every level at or below `level` to the first configuration of
+    // its sub-sequence. Only one level other than the one just advanced
+    // actually changes, by a single bad spot.
+    for (int i = level; i >= 0; i--) {
+        const int target = i == 0 ? remaining[0]
+                           : reversed[i] ? highestOffset(i)
+                                         : lowestOffset(i);
+        while (offset(i) < target) {
+            moveBadSpot(i, 1);
+        }
+        while (offset(i) > target) {
+            moveBadSpot(i, -1);
+        }
+        if (i > 0) {
+            reversed[i - 1] = reversed[i] != (target % 2 == 1);
+            remaining[i - 1] = remaining[i] - target;
+        }
     }
-    return r;
 }
+
+template class PartitionIterator<DoubleWeight>;
+template class PartitionIterator<LogWeight>;
+template class PartitionIterator<ExactWeight>;
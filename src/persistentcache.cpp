@@ -0,0 +1,298 @@
+#include "headers/persistentcache.h"
+
+#include <QByteArray>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+
+// Slot layout: position hash, board check, checksum, total weight, log
+// scale, the statistics of the solve that stored it, then one quantised
+// probability per cell.
+const int hashOffset = 0;
+const int checkOffset = 8;
+const int checksumOffset = 16;
+const int totalWeightOffset = 24;
+const int logScaleOffset = 32;
+const int iterationsOffset = 40;
+const int legalIterationsOffset = 48;
+const int partitionsOffset = 52;
+const int sunkenPartitionsOffset = 56;
+const int constrainedHolesOffset = 60;
+const int deducedHolesOffset = 64;
+const int probabilitiesOffset = 72;
+
+const char *const filePattern = "positions-*.cache";
+
+const uint64_t fnvOffset = 0xcbf29ce484222325ull;
+const uint64_t fnvPrime = 0x100000001b3ull;
+
+uint64_t fnv(uint64_t hash, const uchar *bytes, size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * fnvPrime;
+    }
+    return hash;
+}
+
+// A second hash of the canonical board, so that positions sharing a Zobrist
+// hash are told apart without storing whole boards.
+uint64_t boardCheck(const std::vector<DugType::DugType> &board)
+{
+    uint64_t hash = fnvOffset;
+    for (DugType::DugType type : board) {
+        hash = (hash ^ uint64_t(type - DugType::undug)) * fnvPrime;
+    }
+    return hash;
+}
+
+// 0 and 65535 are kept for certain holes.
+uint16_t quantise(double probability)
+{
+    if (probability <= 0.0) {
+        return 0;
+    }
+    if (probability >= 1.0) {
+        return 65535;
+    }
+    return uint16_t(std::clamp(std::lround(probability * 65535.0), 1L, 65534L));
+}
+
+template <class T> T load(const uchar *slot, int offset)
+{
+    T value;
+    std::memcpy(&value, slot + offset, sizeof(T));
+    return value;
+}
+
+template <class T> void store(uchar *slot, int offset, T value)
+{
+    std::memcpy(slot + offset, &value, sizeof(T));
+}
+
+} // namespace
+
+PersistentCache::PersistentCache(const QString &path,
+                                 const ProblemParameters &params,
+                                 qint64 sizeCap)
+    : file_(path), numHoles_(params.width * params.height)
+{
+    header_.magic = magic;
+    header_.version = version;
+    header_.width = uint32_t(params.width);
+    header_.height = uint32_t(params.height);
+    header_.bombs = uint32_t(params.bombs);
+    header_.rupoors = uint32_t(params.rupoors);
+    header_.slotSize =
+        uint32_t((probabilitiesOffset + 2 * numHoles_ + 7) / 8 * 8);
+    header_.slotCount = uint32_t(std::max<qint64>(
+        1, (sizeCap - qint64(sizeof(FileHeader))) / header_.slotSize));
+
+    if (mapFile(QIODevice::ReadWrite)) {
+        writable_ = true;
+    } else {
+        mapFile(QIODevice::ReadOnly);
+    }
+}
+
+QString PersistentCache::defaultPath(const ProblemParameters &params)
+{
+    const QString directory =
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    return QString("%1/positions-%2x%3-%4-%5.cache")
+        .arg(directory)
+        .arg(params.width)
+        .arg(params.height)
+        .arg(params.bombs)
+        .arg(params.rupoors);
+}
+
+bool PersistentCache::isOpen() const
+{
+    return data_ != nullptr;
+}
+
+bool PersistentCache::find(const TranspositionCache::Key &key,
+                           TranspositionCache::Position &position) const
+{
+    if (data_ == nullptr) {
+        return false;
+    }
+    const uint64_t hash = key.hash == 0 ? 1 : key.hash;
+    const uint64_t check = boardCheck(key.board);
+    std::vector<uchar> entry(header_.slotSize);
+    for (int probe = 0; probe < maxProbes; probe++) {
+        // Copied out first, so that the checksum covers exactly what is read.
+        std::memcpy(entry.data(),
+                    slot((hash + probe) % header_.slotCount),
+                    header_.slotSize);
+        const uint64_t stored = load<uint64_t>(entry.data(), hashOffset);
+        if (stored == 0) {
+            return false;
+        }
+        if (stored != hash ||
+            load<uint64_t>(entry.data(), checkOffset) != check) {
+            continue;
+        }
+        if (load<uint64_t>(entry.data(), checksumOffset) !=
+            checksum(entry.data())) {
+            return false;
+        }
+        position.probabilities.resize(numHoles_);
+        for (int i = 0; i < numHoles_; i++) {
+            position.probabilities[i] =
+                load<uint16_t>(entry.data(), probabilitiesOffset + 2 * i) /
+                65535.0;
+        }
+        position.totalWeight = load<double>(entry.data(), totalWeightOffset);
+        position.logScale = load<double>(entry.data(), logScaleOffset);
+        position.iterations = load<uint64_t>(entry.data(), iterationsOffset);
+        position.legalIterations =
+            load<int32_t>(entry.data(), legalIterationsOffset);
+        position.partitions = load<int32_t>(entry.data(), partitionsOffset);
+        position.sunkenPartitions =
+            load<int32_t>(entry.data(), sunkenPartitionsOffset);
+        position.constrainedHoles =
+            load<int32_t>(entry.data(), constrainedHolesOffset);
+        position.deducedHoles =
+            load<int32_t>(entry.data(), deducedHolesOffset);
+        return true;
+    }
+    return false;
+}
+
+void PersistentCache::insert(const TranspositionCache::Key &key,
+                             const TranspositionCache::Position &position)
+{
+    if (!writable_) {
+        // A missing or stale file is replaced once; a current file that is
+        // merely read-only is left alone.
+        if (data_ != nullptr || creationTried_) {
+            return;
+        }
+        creationTried_ = true;
+        if (!createFile() || !mapFile(QIODevice::ReadWrite)) {
+            return;
+        }
+        writable_ = true;
+    }
+    const uint64_t hash = key.hash == 0 ? 1 : key.hash;
+    // Without a free or matching slot in probe range, the home slot is
+    // overwritten; probe chains stay intact as it never becomes empty.
+    uint64_t target = hash % header_.slotCount;
+    for (int probe = 0; probe < maxProbes; probe++) {
+        const uint64_t index = (hash + probe) % header_.slotCount;
+        const uint64_t stored = load<uint64_t>(slot(index), hashOffset);
+        if (stored == 0 || stored == hash) {
+            target = index;
+            break;
+        }
+    }
+
+    std::vector<uchar> entry(header_.slotSize, 0);
+    store(entry.data(), hashOffset, hash);
+    store(entry.data(), checkOffset, boardCheck(key.board));
+    store(entry.data(), totalWeightOffset, position.totalWeight);
+    store(entry.data(), logScaleOffset, position.logScale);
+    store(entry.data(), iterationsOffset, position.iterations);
+    store(entry.data(),
+          legalIterationsOffset,
+          int32_t(position.legalIterations));
+    store(entry.data(), partitionsOffset, int32_t(position.partitions));
+    store(entry.data(),
+          sunkenPartitionsOffset,
+          int32_t(position.sunkenPartitions));
+    store(entry.data(),
+          constrainedHolesOffset,
+          int32_t(position.constrainedHoles));
+    store(entry.data(), deducedHolesOffset, int32_t(position.deducedHoles));
+    for (int i = 0; i < numHoles_; i++) {
+        store(entry.data(),
+              probabilitiesOffset + 2 * i,
+              quantise(position.probabilities[i]));
+    }
+    store(entry.data(), checksumOffset, checksum(entry.data()));
+    std::memcpy(slot(target), entry.data(), header_.slotSize);
+}
+
+bool PersistentCache::mapFile(QIODevice::OpenMode mode)
+{
+    file_.close();
+    const qint64 size = qint64(sizeof(FileHeader)) +
+                        qint64(header_.slotCount) * header_.slotSize;
+    // Opening for writing would create the file.
+    if (!file_.exists() || !file_.open(mode) || file_.size() != size) {
+        file_.close();
+        return false;
+    }
+    uchar *data = file_.map(0, size);
+    FileHeader existing;
+    if (data != nullptr) {
+        std::memcpy(&existing, data, sizeof(FileHeader));
+    }
+    if (data == nullptr ||
+        std::memcmp(&existing, &header_, sizeof(FileHeader)) != 0) {
+        file_.close();
+        return false;
+    }
+    data_ = data;
+    return true;
+}
+
+// Builds the empty table beside the old file and renames it into place, so
+// that processes still mapping the old file are not disturbed. Cache files of
+// other parameter sets are dropped, oldest first, until the new one fits
+// within totalSizeCap.
+bool PersistentCache::createFile()
+{
+    const QFileInfo target(file_.fileName());
+    QDir().mkpath(target.absolutePath());
+    const QFileInfoList others = target.dir().entryInfoList(
+        QStringList() << filePattern, QDir::Files, QDir::Time);
+    qint64 used = qint64(sizeof(FileHeader)) +
+                  qint64(header_.slotCount) * header_.slotSize;
+    for (const QFileInfo &other : others) {
+        if (other.fileName() == target.fileName()) {
+            continue;
+        }
+        used += other.size();
+        if (used > totalSizeCap) {
+            QFile::remove(other.filePath());
+        }
+    }
+
+    QSaveFile out(file_.fileName());
+    if (!out.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    out.write(reinterpret_cast<const char *>(&header_), sizeof(FileHeader));
+    const QByteArray empty(int(header_.slotSize) * 1024, '\0');
+    for (uint32_t written = 0; written < header_.slotCount;) {
+        const uint32_t slots =
+            std::min<uint32_t>(1024, header_.slotCount - written);
+        out.write(empty.constData(), qint64(slots) * header_.slotSize);
+        written += slots;
+    }
+    return out.commit();
+}
+
+uchar *PersistentCache::slot(uint64_t index) const
+{
+    return data_ + sizeof(FileHeader) + index * header_.slotSize;
+}
+
+uint64_t PersistentCache::checksum(const uchar *slot) const
+{
+    const uint64_t hash = fnv(fnvOffset, slot, checksumOffset);
+    return fnv(hash,
+               slot + totalWeightOffset,
+               header_.slotSize - totalWeightOffset);
+}
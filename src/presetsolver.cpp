@@ -0,0 +1,35 @@
+#include "headers/presetsolver.h"
+
+namespace
+{
+
+template <int Width, int Height>
+void solveShape(const FrontierProblem &problem, FrontierSolution &solution)
+{
+    // One instance per thread: the working arrays are reused between calls
+    // and solvers on different threads must not share them.
+    static thread_local PresetSolver<Width, Height> solver;
+    solver.solve(problem, solution);
+}
+
+} // namespace
+
+bool hasPresetSolver(const ProblemParameters &params)
+{
+    return (params.width == 5 && params.height == 4) ||
+           (params.width == 6 && params.height == 5) ||
+           (params.width == 8 && params.height == 5);
+}
+
+void solvePreset(const ProblemParameters &params,
+                 const FrontierProblem &problem,
+                 FrontierSolution &solution)
+{
+    if (params.width == 5 && params.height == 4) {
+        solveShape<5, 4>(problem, solution);
+    } else if (params.width == 6 && params.height == 5) {
+        solveShape<6, 5>(problem, solution);
+    } else {
+        solveShape<8, 5>(problem, solution);
+    }
+}
@@ -0,0 +1,245 @@
+#include "headers/rolloutevaluator.h"
+
+#include <algorithm>
+
+namespace
+{
+
+int rupeeValue(DugType::DugType type)
+{
+    switch (type) {
+    case DugType::DugType::green:
+        return 1;
+    case DugType::DugType::blue:
+        return 5;
+    case DugType::DugType::red:
+        return 20;
+    case DugType::DugType::silver:
+        return 100;
+    case DugType::DugType::gold:
+        return 300;
+    default:
+        return 0;
+    }
+}
+
+int lowestRiskCell(const std::vector<DugType::DugType> &known,
+                   const std::vector<double> &probabilities)
+{
+    int best = -1;
+    for (int i = 0; i < int(known.size()); i++) {
+        if (known[i] == DugType::DugType::undug &&
+            (best == -1 || probabilities[i] < probabilities[best])) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+double RolloutEstimate::winProbability() const
+{
+    return rollouts > 0 ? double(wins) / rollouts : 0.0;
+}
+
+double RolloutEstimate::expectedRupees() const
+{
+    return rollouts > 0 ? rupees / rollouts : 0.0;
+}
+
+RolloutEvaluator::Worker::Worker(const ProblemParameters &params,
+                                 TranspositionCache *cache)
+    : solver(params),
+      board(params),
+      rng(std::random_device()()),
+      layout(params.width * params.height),
+      known(params.width * params.height)
+{
+    solver.setTranspositionCache(cache);
+    solver.setLogging(false);
+}
+
+RolloutEvaluator::RolloutEvaluator(const ProblemParameters &params,
+                                   int threads)
+    : params_(params),
+      numHoles_(params.width * params.height),
+      solver_(params),
+      sampler_(params)
+{
+    solver_.setTranspositionCache(&cache_);
+    solver_.setLogging(false);
+    if (threads <= 0) {
+        threads = std::max(1, int(std::thread::hardware_concurrency()));
+    }
+    for (int i = 0; i < threads; i++) {
+        workers_.push_back(std::make_unique<Worker>(params_, &cache_));
+    }
+    for (const std::unique_ptr<Worker> &worker : workers_) {
+        worker->thread =
+            std::thread(&RolloutEvaluator::work, this, std::ref(*worker));
+    }
+}
+
+RolloutEvaluator::~RolloutEvaluator()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (const std::unique_ptr<Worker> &worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+void RolloutEvaluator::setTimeBudget(std::chrono::milliseconds budget)
+{
+    budget_ = budget;
+}
+
+void RolloutEvaluator::setMaxCandidates(int candidates)
+{
+    maxCandidates_ = std::max(candidates, 1);
+}
+
+void RolloutEvaluator::setMaxSamples(int samples)
+{
+    maxSamples_ = std::max(samples, 0);
+}
+
+const std::vector<RolloutEstimate> &
+RolloutEvaluator::evaluate(const std::vector<DugType::DugType> &position,
+                           int rupees)
+{
+    estimates_.clear();
+    candidates_.clear();
+    position_ = position;
+    rupees_ = rupees;
+    solver_.loadBoard(position_.data());
+    solver_.partitionCalculate();
+    const std::vector<double> &probabilities = solver_.getProbabilityArray();
+    for (int i = 0; i < numHoles_; i++) {
+        if (position_[i] == DugType::DugType::undug &&
+            solver_.getHoleState(i) != Solver::HoleState::knownBad) {
+            candidates_.push_back(i);
+        }
+    }
+    std::stable_sort(candidates_.begin(), candidates_.end(), [&](int a, int b) {
+        return probabilities[a] < probabilities[b];
+    });
+    if (int(candidates_.size()) > maxCandidates_) {
+        candidates_.resize(maxCandidates_);
+    }
+    for (int cell : candidates_) {
+        RolloutEstimate estimate;
+        estimate.cell = cell;
+        estimate.probability = probabilities[cell];
+        estimates_.push_back(estimate);
+    }
+    if (candidates_.empty() || !sampler_.prepare(solver_)) {
+        return estimates_;
+    }
+
+    nextSample_ = 0;
+    deadline_ = std::chrono::steady_clock::now() + budget_;
+    std::unique_lock<std::mutex> lock(mutex_);
+    running_ = int(workers_.size());
+    round_++;
+    wake_.notify_all();
+    finished_.wait(lock, [&] { return running_ == 0; });
+    return estimates_;
+}
+
+int RolloutEvaluator::bestMove() const
+{
+    const RolloutEstimate *best = nullptr;
+    for (const RolloutEstimate &estimate : estimates_) {
+        if (best == nullptr ||
+            estimate.winProbability() > best->winProbability() ||
+            (estimate.winProbability() == best->winProbability() &&
+             estimate.expectedRupees() > best->expectedRupees())) {
+            best = &estimate;
+        }
+    }
+    return best != nullptr ? best->cell : -1;
+}
+
+void RolloutEvaluator::work(Worker &worker)
+{
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [&] { return stopping_ || round_ != seen; });
+        if (stopping_) {
+            return;
+        }
+        seen = round_;
+        lock.unlock();
+
+        worker.estimates.assign(candidates_.size(), RolloutEstimate());
+        for (size_t c = 0; c < candidates_.size(); c++) {
+            worker.estimates[c].cell = candidates_[c];
+        }
+        while (std::chrono::steady_clock::now() < deadline_ &&
+               nextSample_++ < maxSamples_) {
+            sampler_.sample(worker.rng, worker.layout);
+            for (RolloutEstimate &estimate : worker.estimates) {
+                rollout(worker, estimate);
+            }
+        }
+
+        lock.lock();
+        for (size_t c = 0; c < estimates_.size(); c++) {
+            estimates_[c].rollouts += worker.estimates[c].rollouts;
+            estimates_[c].wins += worker.estimates[c].wins;
+            estimates_[c].rupees += worker.estimates[c].rupees;
+        }
+        if (--running_ == 0) {
+            finished_.notify_one();
+        }
+    }
+}
+
+// Plays the sampled layout of `worker` out from the position, digging the
+// candidate first and then always the lowest-risk cell.
+void RolloutEvaluator::rollout(Worker &worker, RolloutEstimate &estimate)
+{
+    worker.board.load(worker.layout.data());
+    for (int i = 0; i < numHoles_; i++) {
+        if (position_[i] != DugType::DugType::undug) {
+            worker.board.getCell(i % params_.width, i / params_.width);
+        }
+    }
+    worker.known = position_;
+    worker.solver.loadBoard(position_.data());
+
+    int rupees = rupees_;
+    bool won = false;
+    int cell = estimate.cell;
+    while (cell != -1) {
+        const int x = cell % params_.width;
+        const int y = cell / params_.width;
+        const DugType::DugType type = worker.board.getCell(x, y);
+        worker.known[cell] = type;
+        if (type == DugType::DugType::bomb) {
+            break;
+        }
+        if (type == DugType::DugType::rupoor) {
+            rupees = std::max(rupees - 10, 0);
+        } else {
+            rupees += rupeeValue(type);
+        }
+        if (worker.board.hasWon()) {
+            won = true;
+            break;
+        }
+        worker.solver.setCell(x, y, type);
+        worker.solver.partitionCalculate();
+        cell =
+            lowestRiskCell(worker.known, worker.solver.getProbabilityArray());
+    }
+    estimate.rollouts++;
+    estimate.wins += won ? 1 : 0;
+    estimate.rupees += rupees;
+}
@@ -49,7 +49,8 @@ void SettingsWindow::on_SolverButton_clicked()
             if (solver != nullptr) {
                 solver->close();
             }
-            solver = std::make_unique<SolverWindow>(params);
+            solver = std::make_unique<SolverWindow>(
+                params, ui->keepPositionsCheckBox->isChecked());
 
             connect(solver.get(),
                     SIGNAL(closing()),
@@ -133,7 +134,8 @@ void SettingsWindow::on_bothButton_clicked()
                                 ui->rupoorsSpinner->value()};
     if (params.height * params.width > 0) {
         if (params.height * params.width > params.bombs + params.rupoors) {
-            solver = std::make_unique<SolverWindow>(params);
+            solver = std::make_unique<SolverWindow>(
+                params, ui->keepPositionsCheckBox->isChecked());
             simulator = std::make_unique<SimulatorWindow>(params);
 
             connect(simulator.get(),
@@ -180,7 +182,11 @@ void SettingsWindow::on_benchmarkButton_clicked()
         ui->bothButton->setEnabled(false);
         ui->benchmarkButton->setEnabled(false);
 
-        benchmark = std::make_unique<Benchmark>(params);
+        BenchmarkOptions options;
+        options.rollouts = ui->rolloutsCheckBox->isChecked();
+        options.optimalPlay = ui->optimalPlayCheckBox->isChecked();
+        options.exactCounts = ui->exactCountsCheckBox->isChecked();
+        benchmark = std::make_unique<Benchmark>(params, options);
         connect(benchmark.get(), SIGNAL(done()), this, SLOT(benchmarkDone()));
         benchmark->start();
     }
@@ -1,81 +1,160 @@
 #include "headers/solver.h"
 
+#include "headers/boarddatabase.h"
 #include "headers/constraint.h"
+#include "headers/neighbortable.h"
+#include "headers/openingbook.h"
 #include "headers/partition.h"
 #include "headers/partitioniterator.h"
+#include "headers/persistentcache.h"
+#include "headers/presetsolver.h"
 #include "headers/problemparameters.h"
 #include <QSet>
 #include <QSetIterator>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <unordered_map>
 
-Solver::Solver(const ProblemParameters &params)
+namespace
+{
+
+// Layout counts beyond e^600 come close to overflowing a double.
+const double maxDoubleLog = 600.0;
+// Exact counts wrap past 2^128.
+const double maxExactLog = 128 * std::log(2.0);
+
+// Marks all of `holes` safe or bad when a count in [low, high] allows
+// nothing else.
+void classifyHoles(const std::vector<int> &holes,
+                   int low,
+                   int high,
+                   std::vector<int> &safe,
+                   std::vector<int> &bad)
+{
+    if (holes.empty()) {
+        return;
+    }
+    if (high <= 0) {
+        safe.insert(safe.end(), holes.begin(), holes.end());
+    } else if (low >= int(holes.size())) {
+        bad.insert(bad.end(), holes.begin(), holes.end());
+    }
+}
+
+// Subset and difference reasoning on two overlapping constraints: bounds the
+// bad count of the shared holes from both sides, then bounds each
+// constraint's remaining holes by what the shared holes leave over.
+void deducePair(const Constraint &a,
+                const Constraint &b,
+                std::vector<int> &safe,
+                std::vector<int> &bad)
+{
+    std::vector<int> shared;
+    std::vector<int> onlyA;
+    std::vector<int> onlyB;
+    for (int hole : a.holes) {
+        if (std::find(b.holes.begin(), b.holes.end(), hole) != b.holes.end()) {
+            shared.push_back(hole);
+        } else {
+            onlyA.push_back(hole);
+        }
+    }
+    for (int hole : b.holes) {
+        if (std::find(a.holes.begin(), a.holes.end(), hole) == a.holes.end()) {
+            onlyB.push_back(hole);
+        }
+    }
+    const int lowA = std::max(a.maxBadness - 1, 0);
+    const int lowB = std::max(b.maxBadness - 1, 0);
+    const int low = std::max({0,
+                              lowA - int(onlyA.size()),
+                              lowB - int(onlyB.size())});
+    const int high =
+        std::min({int(shared.size()), a.maxBadness, b.maxBadness});
+    if (low > high) {
+        return;
+    }
+    classifyHoles(shared, low, high, safe, bad);
+    classifyHoles(onlyA, lowA - high, a.maxBadness - low, safe, bad);
+    classifyHoles(onlyB, lowB - high, b.maxBadness - low, safe, bad);
+}
+
+// The probability of a hole that can go either way. Rounding never takes it
+// to 0 or 1, which the caches and the move strategies read as certain.
+double uncertainProbability(double weight, double totalWeight)
+{
+    return std::clamp(weight / totalWeight,
+                      std::numeric_limits<double>::denorm_min(),
+                      std::nextafter(1.0, 0.0));
+}
+
+} // namespace
+
+Solver::Solver(const ProblemParameters &params, Storage storage)
     : params_(params),
       numHoles(params_.width * params_.height),
-      probabilities(numHoles, 0.0),
-      constraints(numHoles),
-      partitions(numHoles),
+      sparse(storage == Storage::sparse ||
+             (storage == Storage::automatic && numHoles > sparseHoles)),
+      neighbors(NeighborTable::forShape(params_.width, params_.height)),
+      probabilities(sparse ? 0 : numHoles, 0.0),
+      outcomes(numHoles, 0),
+      constraints(sparse ? 0 : numHoles),
       badSpots(numHoles, false),
-      imposingConstraints(numHoles),
-      board(numHoles, DugType::undug)
+      imposingConstraints(sparse ? 0 : numHoles),
+      cells(numHoles),
+      publishing(!sparse),
+      columnSweep(params_),
+      symmetries(sparse ? std::vector<std::vector<int>>()
+                        : TranspositionCache::symmetries(params_.width,
+                                                         params_.height)),
+      cacheBoard(sparse ? 0 : numHoles)
 {
 
-    for (int i = 0; i < numHoles; i++) {
-
-        unconstrainedUnopenedHoles.insert(i);
-        constraints[i].maxBadness = -1;
-    }
-    std::cout << "True number of configurations\tTotal iterations\tLegal "
-              << "iterations\tPartitions\tSunken Partitions\tConstrained holes"
-              << std::endl;
+    stateCounts[int(HoleState::unconstrained)] = numHoles;
 }
 
 void Solver::setCell(int x, int y, DugType::DugType type)
 {
 
     int index = y * params_.width + x;
-    int filterIndex;
-    if (board[index] != DugType::DugType::undug && board[index] != type) {
-        board[index] = DugType::DugType::undug;
+    boardGeneration++;
+    if (cell(index).type != DugType::DugType::undug &&
+        cell(index).type != type) {
+        cell(index).type = DugType::DugType::undug;
         resetBoard();
     }
-    board[index] = type;
+    cell(index).type = type;
     if (type >= 0) {
-        Constraint *constraint = &constraints[index];
+        Constraint *constraint = &constraintAt(index);
         constraint->maxBadness = type;
 
-        for (int filterY = y - 1; filterY < y + 2; filterY++) {
-            if (filterY >= 0 && filterY < params_.height) {
-                for (int filterX = x - 1; filterX < x + 2; filterX++) {
-                    if (filterX >= 0 && filterX < params_.width) {
-                        if (filterX != x || filterY != y) {
-                            filterIndex = filterY * params_.width + filterX;
-                            if (knownBadSpots.count(filterIndex)) {
-                                constraint->maxBadness--;
-                            } else if (board[filterIndex] ==
-                                       DugType::DugType::undug) {
-
-                                imposingConstraints[filterIndex].insert(
-                                    constraint);
-
-                                if (!knownSafeSpots.count(filterIndex)) {
-                                    constraint->holes.push_back(filterIndex);
-                                    constrainedUnopenedHoles.insert(
-                                        filterIndex);
-                                }
-                                unconstrainedUnopenedHoles.erase(filterIndex);
-                            }
-                        }
-                    }
+        const NeighborTable::Range range = (*neighbors)[index];
+        for (int slot = 0; slot < range.size(); slot++) {
+            const int filterIndex = range.first[slot];
+            const CellRecord &neighbor = cell(filterIndex);
+            if (neighbor.state == HoleState::knownBad) {
+                constraint->maxBadness--;
+            } else if (neighbor.type == DugType::DugType::undug) {
+
+                imposingConstraintsOf(filterIndex).insert(constraint);
+
+                if (neighbor.state != HoleState::knownSafe) {
+                    constraint->addHole(filterIndex, slot);
+                    setHoleState(filterIndex, HoleState::constrained);
                 }
             }
         }
-        setKnownSafeSpot(index);
+        // Listed before the cell is marked safe, so that deductions cascading
+        // back into this constraint also update its list membership.
         if (constraint->maxBadness > 0) {
-            constraintList.push_back(constraint);
+            activateConstraint(constraint);
         }
+        setKnownSafeSpot(index);
         if (constraint->maxBadness == 0) {
-            for (int hole : constraint->holes) {
-                setKnownSafeSpot(hole);
+            while (!constraint->holes.empty()) {
+                setKnownSafeSpot(constraint->popHole());
             }
         }
     } else if (type >= -2) {
@@ -83,151 +162,1003 @@ void Solver::setCell(int x, int y, DugType::DugType type)
     }
 }
 
-void Solver::resetBoard()
+void Solver::loadBoard(const Vector2d<DugType::DugType> &board)
 {
+    loadBoard(&board[0]);
+}
 
-    constraintList.clear();
-    constrainedUnopenedHoles.clear();
-    unconstrainedUnopenedHoles.clear();
-    knownBadSpots.clear();
-    knownSafeSpots.clear();
-    std::fill(badSpots.begin(), badSpots.end(), false);
+void Solver::loadBoard(const DugType::DugType *types)
+{
+    boardGeneration++;
+    startEpoch();
     for (int i = 0; i < numHoles; i++) {
-
-        constraints[i].maxBadness = -1;
-        constraints[i].holes.clear();
-        unconstrainedUnopenedHoles.insert(i);
-        imposingConstraints[i].clear();
+        CellRecord &record = cell(i);
+        record.type = types[i];
+        if (types[i] >= 0) {
+            setHoleState(i, HoleState::knownSafe);
+            setProbability(i, 0.0);
+        } else if (types[i] >= -2) {
+            setHoleState(i, HoleState::knownBad);
+            badSpots[i] = true;
+            setProbability(i, 1.0);
+        }
     }
-    int x;
-    int y;
+
+    // Every opened cell is final by now, so each constraint is built once
+    // against the known bad cells and only undug cells become holes.
     for (int i = 0; i < numHoles; i++) {
+        if (types[i] < 0) {
+            continue;
+        }
+        Constraint *constraint = &constraintAt(i);
+        constraint->maxBadness = types[i];
+        const NeighborTable::Range range = (*neighbors)[i];
+        for (int slot = 0; slot < range.size(); slot++) {
+            const int filterIndex = range.first[slot];
+            const CellRecord &neighbor = cell(filterIndex);
+            if (neighbor.state == HoleState::knownBad) {
+                constraint->maxBadness--;
+            } else if (neighbor.type == DugType::DugType::undug) {
+                imposingConstraintsOf(filterIndex).insert(constraint);
+                constraint->addHole(filterIndex, slot);
+                setHoleState(filterIndex, HoleState::constrained);
+            }
+        }
+        if (constraint->maxBadness > 0) {
+            activateConstraint(constraint);
+        }
+    }
 
-        if (board[i] != DugType::DugType::undug) {
-            x = i % params_.width;
-            y = i / params_.width;
-            setCell(x, y, board[i]);
+    for (int i = 0; i < numHoles; i++) {
+        if (types[i] >= 0) {
+            settleConstraint(&constraintAt(i));
         }
     }
 }
 
+void Solver::resetBoard()
+{
+    std::vector<DugType::DugType> types(numHoles);
+    for (int i = 0; i < numHoles; i++) {
+        types[i] = cell(i).type;
+    }
+    loadBoard(types.data());
+}
+
 void Solver::reload()
+{
+    boardGeneration++;
+    startEpoch();
+}
+
+void Solver::startEpoch()
 {
     constraintList.clear();
-    constrainedUnopenedHoles.clear();
-    unconstrainedUnopenedHoles.clear();
-    knownBadSpots.clear();
-    knownSafeSpots.clear();
+    usedDetails = 0;
+    frontier.clear();
+    changedCells.clear();
+    contradiction = false;
+    stateCounts = {};
+    stateCounts[int(HoleState::unconstrained)] = numHoles;
+    if (++epoch == 0) {
+        for (CellRecord &record : cells) {
+            record.epoch = 0;
+        }
+        epoch = 1;
+    }
+}
+
+Solver::CellRecord &Solver::cell(int index)
+{
+    CellRecord &record = cells[index];
+    if (record.epoch != epoch) {
+        record = CellRecord();
+        record.epoch = epoch;
+        if (!sparse) {
+            constraints[index].maxBadness = -1;
+            constraints[index].listPosition = -1;
+            constraints[index].clearHoles();
+            imposingConstraints[index].clear();
+        }
+        badSpots[index] = false;
+    }
+    return record;
+}
+
+Solver::CellDetail &Solver::detail(int index)
+{
+    CellRecord &record = cell(index);
+    if (record.detail == -1) {
+        if (usedDetails == details.size()) {
+            details.emplace_back();
+        }
+        CellDetail &entry = details[usedDetails];
+        entry.constraint.maxBadness = -1;
+        entry.constraint.listPosition = -1;
+        entry.constraint.clearHoles();
+        entry.imposingConstraints.clear();
+        entry.probability = 0.0;
+        entry.frontierPosition = -1;
+        record.detail = int(usedDetails++);
+    }
+    return details[record.detail];
+}
+
+Constraint &Solver::constraintAt(int index)
+{
+    return sparse ? detail(index).constraint : constraints[index];
+}
+
+std::unordered_set<Constraint *> &Solver::imposingConstraintsOf(int hole)
+{
+    return sparse ? detail(hole).imposingConstraints
+                  : imposingConstraints[hole];
+}
+
+// Under sparse storage only constrained holes hold a probability of their
+// own; known cells are certain and unconstrained holes share theirs.
+double Solver::probability(int index)
+{
+    if (!sparse) {
+        return probabilities[index];
+    }
+    switch (cell(index).state) {
+    case HoleState::constrained:
+        return detail(index).probability;
+    case HoleState::unconstrained:
+        return unconstrainedProbability;
+    case HoleState::knownBad:
+        return 1.0;
+    default:
+        return 0.0;
+    }
+}
+
+void Solver::setProbability(int index, double value)
+{
+    if (!sparse) {
+        probabilities[index] = value;
+        return;
+    }
+    probabilitiesExpanded = false;
+    switch (cell(index).state) {
+    case HoleState::constrained:
+        detail(index).probability = value;
+        break;
+    case HoleState::unconstrained:
+        unconstrainedProbability = value;
+        break;
+    default:
+        break;
+    }
+}
+
+uint8_t Solver::holeOutcomes(int index)
+{
+    if (sparse && cell(index).state == HoleState::unconstrained) {
+        return unconstrainedOutcomes;
+    }
+    return outcomes[index];
+}
+
+void Solver::addOutcomes(int index, uint8_t values)
+{
+    if (sparse && cell(index).state == HoleState::unconstrained) {
+        unconstrainedOutcomes |= values;
+    } else {
+        outcomes[index] |= values;
+    }
+}
+
+// The unconstrained holes form the one partition without constraints, and
+// share their weight under sparse storage.
+void Solver::addPartitionWeight(const Partition *partition,
+                                double weight,
+                                uint8_t values)
+{
+    if (sparse && partition->constraints.empty()) {
+        unconstrainedProbability += weight;
+        unconstrainedOutcomes |= values;
+        probabilitiesExpanded = false;
+        return;
+    }
+    for (int hole : partition->holes) {
+        setProbability(hole, probability(hole) + weight);
+        outcomes[hole] |= values;
+    }
+}
+
+void Solver::expandProbabilities() const
+{
+    probabilities.resize(numHoles);
     for (int i = 0; i < numHoles; i++) {
+        const CellRecord &record = cells[i];
+        const HoleState state =
+            record.epoch == epoch ? record.state : HoleState::unconstrained;
+        switch (state) {
+        case HoleState::constrained:
+            probabilities[i] = details[record.detail].probability;
+            break;
+        case HoleState::unconstrained:
+            probabilities[i] = unconstrainedProbability;
+            break;
+        case HoleState::knownBad:
+            probabilities[i] = 1.0;
+            break;
+        default:
+            probabilities[i] = 0.0;
+            break;
+        }
+    }
+    probabilitiesExpanded = true;
+}
 
-        constraints[i].maxBadness = -1;
-        constraints[i].holes.clear();
-        unconstrainedUnopenedHoles.insert(i);
-        imposingConstraints[i].clear();
+bool Solver::isUnknown(int index)
+{
+    const HoleState state = cell(index).state;
+    return state == HoleState::constrained ||
+           state == HoleState::unconstrained;
+}
+
+void Solver::setHoleState(int index, HoleState state)
+{
+    CellRecord &record = cell(index);
+    if (sparse) {
+        if (record.state == HoleState::constrained &&
+            state != HoleState::constrained) {
+            // A freed hole keeps its value if no other hole shares one.
+            if (state == HoleState::unconstrained &&
+                countHoles(HoleState::unconstrained) == 0) {
+                unconstrainedProbability = detail(index).probability;
+            }
+            const int position = detail(index).frontierPosition;
+            frontier[position] = frontier.back();
+            detail(frontier[position]).frontierPosition = position;
+            frontier.pop_back();
+            detail(index).frontierPosition = -1;
+        } else if (state == HoleState::constrained &&
+                   record.state != HoleState::constrained) {
+            CellDetail &entry = detail(index);
+            entry.probability = record.state == HoleState::unconstrained
+                                    ? unconstrainedProbability
+                                    : 0.0;
+            entry.frontierPosition = int(frontier.size());
+            frontier.push_back(index);
+        }
+        changedCells.push_back(index);
+        probabilitiesExpanded = false;
     }
-    std::fill(badSpots.begin(), badSpots.end(), false);
-    std::fill(board.begin(), board.end(), DugType::DugType::undug);
+    stateCounts[int(record.state)]--;
+    stateCounts[int(state)]++;
+    record.state = state;
 }
 
-void Solver::partitionCalculate()
+int Solver::countHoles(HoleState state) const
 {
-    generatePartitions();
-    PartitionIterator it(&partitionList,
-                         badSpots,
-                         &sunkenPartitions,
-                         params_.bombs + params_.rupoors -
-                             int(knownBadSpots.size()));
-
-    bombsAmongConstrainedHoles = params_.bombs + params_.rupoors;
-    double configurationWeight;
-    totalWeight = 0.0;
-    double probability;
+    return stateCounts[int(state)];
+}
+
+void Solver::collectHoles(HoleState state, std::vector<int> &holes)
+{
+    if (sparse && state == HoleState::constrained) {
+        // Sorted, so that partitions come out as under dense storage.
+        holes = frontier;
+        std::sort(holes.begin(), holes.end());
+        return;
+    }
+    holes.clear();
     for (int i = 0; i < numHoles; i++) {
+        if (cell(i).state == state) {
+            holes.push_back(i);
+        }
+    }
+}
 
-        if (constrainedUnopenedHoles.count(i) ||
-            unconstrainedUnopenedHoles.count(i)) {
-            probabilities[i] = 0.0;
+void Solver::partitionCalculate()
+{
+    // Positions are keyed by the board alone, so a solver told how to solve
+    // must not be answered from another solver's results.
+    const bool caching =
+        !sparse && engine == Engine::automatic &&
+        arithmetic == Arithmetic::automatic &&
+        (transpositionCache != nullptr || persistentCache != nullptr ||
+         openingBook != nullptr);
+    int symmetry = 0;
+    bool cached = false;
+    if (caching) {
+        for (int i = 0; i < numHoles; i++) {
+            cacheBoard[i] = cell(i).type;
         }
+        symmetry = TranspositionCache::makeKey(
+            params_, symmetries, cacheBoard, cacheKey);
+        cacheLookups++;
+        cached = findPosition();
     }
-    totalIterations = 0;
-    legalIterations = 0;
-    do {
-        configurationWeight = it.iterate();
-        totalIterations++;
-        if (!validateBoard()) {
-            continue;
+    if (cached) {
+        cacheHits++;
+        applyCachedPosition(symmetry);
+    } else {
+        solvePosition();
+    }
+
+    if (logging) {
+        if (!headerLogged) {
+            std::cout << "True number of configurations\tTotal iterations\t"
+                      << "Legal iterations\tPartitions\tSunken Partitions\t"
+                      << "Constrained holes\tDeduced holes\tCache hit"
+                      << std::endl;
+            headerLogged = true;
         }
-        legalIterations++;
+        std::cout << totalWeight << "\t" << totalIterations << "\t"
+                  << legalIterations << "\t" << numPartitions << "\t"
+                  << numSunkenPartitions << "\t" << numConstrained << "\t"
+                  << deducedHoles << "\t" << cached << std::endl;
+    }
+    if (caching && !cached) {
+        storePosition(symmetry);
+    }
+    publishSnapshot(cached);
 
-        totalWeight += configurationWeight;
+    emit done();
+}
 
-        for (auto i : partitionList) {
-            probability =
-                configurationWeight * i->badness / double(i->holes.size());
-            for (int hole : i->holes) {
-                probabilities[hole] += probability;
+void Solver::solvePosition()
+{
+    const Engine active = activeEngine();
+    // The database is exact on its own; certain holes fall out of its
+    // counts below.
+    deducedHoles = active == Engine::boardDatabase ? 0 : deduce();
+    if (sparse) {
+        for (int hole : frontier) {
+            setProbability(hole, 0.0);
+            outcomes[hole] = 0;
+        }
+        unconstrainedProbability = 0.0;
+        unconstrainedOutcomes = 0;
+    } else {
+        for (int i = 0; i < numHoles; i++) {
+
+            if (isUnknown(i)) {
+                probabilities[i] = 0.0;
+                outcomes[i] = 0;
             }
         }
+    }
+    // A position no layout agrees with is left with zero weights, before
+    // an engine can mark holes from a board that cannot happen.
+    if (!isConsistent()) {
+        totalWeight = 0.0;
+        weightLogScale = 0.0;
+        totalIterations = 0;
+        legalIterations = 0;
+        numPartitions = 0;
+        numSunkenPartitions = 0;
+        numConstrained = countHoles(HoleState::constrained);
+        return;
+    }
+    switch (active) {
+    case Engine::preset:
+        buildFrontierProblem();
+        solvePreset(params_, frontierProblem, frontierSolution);
+        applyFrontierSolution();
+        break;
+    case Engine::columnSweep:
+        buildFrontierProblem();
+        columnSweep.solve(frontierProblem, frontierSolution);
+        applyFrontierSolution();
+        break;
+    case Engine::variableElimination:
+        buildFrontierProblem();
+        if (variableElimination.solve(frontierProblem, frontierSolution)) {
+            applyFrontierSolution();
+        } else {
+            enumeratePartitions();
+        }
+        break;
+    case Engine::boardDatabase:
+        lookUpDatabase();
+        break;
+    default:
+        enumeratePartitions();
+        break;
+    }
 
-    } while (it.hasNext());
+    numConstrained = countHoles(HoleState::constrained);
+    // The engines find no layout for a contradiction the check above
+    // missed; every count of a possible layout is above zero.
+    if (totalWeight == 0.0) {
+        return;
+    }
+    if (sparse) {
+        normalizeFrontier();
+    } else {
+        for (int i = 0; i < numHoles; i++) {
+            if (isUnknown(i)) {
+                if ((outcomes[i] & Outcomes::safe) == 0) {
+                    setKnownBadSpot(i);
+                } else if ((outcomes[i] & Outcomes::bad) == 0) {
+                    setKnownSafeSpot(i);
+                } else {
+                    badSpots[i] = false;
+                    probabilities[i] =
+                        uncertainProbability(probabilities[i], totalWeight);
+                }
+            }
+        }
+    }
+}
 
-    for (auto sunkenPartition : sunkenPartitions) {
-        probability = totalWeight * sunkenPartition->badness /
-                      double(sunkenPartition->holes.size());
-        for (int hole: sunkenPartition->holes) {
-            probabilities[hole] += probability;
+// Every weight is turned into a probability before any hole is marked,
+// as a mark can free a frontier hole, which then reads the shared value.
+void Solver::normalizeFrontier()
+{
+    std::vector<int> bad;
+    std::vector<int> safe;
+    for (int hole : frontier) {
+        CellDetail &entry = detail(hole);
+        if ((outcomes[hole] & Outcomes::safe) == 0) {
+            bad.push_back(hole);
+        } else if ((outcomes[hole] & Outcomes::bad) == 0) {
+            safe.push_back(hole);
+        } else {
+            badSpots[hole] = false;
+            entry.probability =
+                uncertainProbability(entry.probability, totalWeight);
         }
     }
-    numConstrained = int(constrainedUnopenedHoles.size());
-    std::cout << totalWeight << "\t" << totalIterations << "\t"
-              << legalIterations << "\t"
-              << partitionList.size() + sunkenPartitions.size() << "\t"
-              << sunkenPartitions.size() << "\t"
-              << constrainedUnopenedHoles.size() << std::endl;
-    for (int i = 0; i < numHoles; i++) {
-        if (constrainedUnopenedHoles.count(i) ||
-            unconstrainedUnopenedHoles.count(i)) {
-            if (probabilities[i] == totalWeight) {
-                setKnownBadSpot(i);
-            } else if (probabilities[i] == 0.0) {
-                setKnownSafeSpot(i);
+    // The shared outcomes decide for every unconstrained hole at once.
+    const bool unconstrainedBad =
+        (unconstrainedOutcomes & Outcomes::safe) == 0;
+    const bool unconstrainedSafe =
+        !unconstrainedBad && (unconstrainedOutcomes & Outcomes::bad) == 0;
+    const bool unconstrainedCertain =
+        countHoles(HoleState::unconstrained) > 0 &&
+        (unconstrainedBad || unconstrainedSafe);
+    if (!unconstrainedBad && !unconstrainedSafe) {
+        unconstrainedProbability =
+            uncertainProbability(unconstrainedProbability, totalWeight);
+    }
+    probabilitiesExpanded = false;
+
+    for (int hole : bad) {
+        if (isUnknown(hole)) {
+            setKnownBadSpot(hole);
+        }
+    }
+    for (int hole : safe) {
+        if (isUnknown(hole)) {
+            setKnownSafeSpot(hole);
+        }
+    }
+    if (unconstrainedCertain) {
+        std::vector<int> holes;
+        collectHoles(HoleState::unconstrained, holes);
+        for (int hole : holes) {
+            if (unconstrainedBad) {
+                setKnownBadSpot(hole);
             } else {
-                badSpots[i] = false;
-                probabilities[i] /= totalWeight;
+                setKnownSafeSpot(hole);
             }
         }
     }
+}
 
-    emit done();
+// Deductions assume a position some layout agrees with, and constraints are
+// dropped once their holes are known, so a contradiction can slip past the
+// engines. Recounting every opened cell against the deduced hole states
+// catches it; sparse storage recounts only those next to a changed cell.
+bool Solver::isConsistent()
+{
+    int knownBad = 0;
+    int unknown = 0;
+    if (sparse) {
+        for (int changed : changedCells) {
+            contradiction = contradiction || !isCellConsistent(changed);
+            for (int neighbor : (*neighbors)[changed]) {
+                contradiction = contradiction || !isCellConsistent(neighbor);
+            }
+        }
+        changedCells.clear();
+        if (contradiction) {
+            return false;
+        }
+        knownBad = countHoles(HoleState::knownBad);
+        unknown = countHoles(HoleState::unconstrained) +
+                  countHoles(HoleState::constrained);
+    } else {
+        for (int i = 0; i < numHoles; i++) {
+            knownBad += cell(i).state == HoleState::knownBad ? 1 : 0;
+            unknown += isUnknown(i) ? 1 : 0;
+            if (!isCellConsistent(i)) {
+                return false;
+            }
+        }
+    }
+    const int totalBad = params_.bombs + params_.rupoors;
+    return knownBad <= totalBad && knownBad + unknown >= totalBad;
 }
 
-const std::vector<double> &Solver::getProbabilityArray() const
+// Whether an opened cell's clue still fits the known bad cells around it
+// and the unknown ones left; other cells always pass.
+bool Solver::isCellConsistent(int index)
 {
-    return probabilities;
+    const int type = cell(index).type;
+    if (type < 0) {
+        return true;
+    }
+    int bad = 0;
+    int open = 0;
+    for (int neighbor : (*neighbors)[index]) {
+        bad += cell(neighbor).state == HoleState::knownBad ? 1 : 0;
+        open += isUnknown(neighbor) ? 1 : 0;
+    }
+    return bad <= type && bad + open >= type - 1;
 }
 
-bool Solver::validateBoard()
+void Solver::publishSnapshot(bool cached)
 {
-    if (bombsAmongConstrainedHoles > params_.bombs + params_.rupoors) {
-        return false;
+    if (!publishing) {
+        return;
     }
-    if (int(unconstrainedUnopenedHoles.size()) + bombsAmongConstrainedHoles <
-        params_.bombs + params_.rupoors) {
-        return false;
+    auto snapshot = std::make_shared<SolverSnapshot>();
+    snapshot->generation = boardGeneration;
+    snapshot->probabilities = getProbabilityArray();
+    double lowest = 1.0;
+    for (int i = 0; i < numHoles; i++) {
+        if (cell(i).type == DugType::DugType::undug) {
+            lowest = std::min(lowest, probabilities[i]);
+        }
     }
-    for (Constraint *constraint : constraintList) {
-        int badSpotsSeen = 0;
-        for (int constrainedHole : constraint->holes) {
-            if (badSpots[constrainedHole]) {
-                badSpotsSeen++;
+    for (int i = 0; i < numHoles; i++) {
+        if (cell(i).type == DugType::DugType::undug &&
+            probabilities[i] == lowest) {
+            snapshot->lowestRisk.push_back(i);
+        }
+    }
+    snapshot->totalConfigurations = getTotalNumConfigurations();
+    snapshot->iterations = totalIterations;
+    snapshot->legalIterations = legalIterations;
+    snapshot->partitions = numPartitions;
+    snapshot->constrainedHoles = numConstrained;
+    snapshot->deducedHoles = deducedHoles;
+    snapshot->cacheHit = cached;
+    std::shared_ptr<const SolverSnapshot> published = std::move(snapshot);
+    std::atomic_store(&publishedSnapshot, std::move(published));
+}
+
+bool Solver::findPosition()
+{
+    if (openingBook != nullptr &&
+        openingBook->find(cacheKey, cachedPosition)) {
+        return true;
+    }
+    if (transpositionCache != nullptr &&
+        transpositionCache->find(cacheKey, cachedPosition)) {
+        return true;
+    }
+    // Persistent hits are quantised, so they are not passed on to solvers
+    // sharing the transposition cache.
+    return persistentCache != nullptr &&
+           persistentCache->find(cacheKey, cachedPosition);
+}
+
+void Solver::storePosition(int symmetry)
+{
+    cachedPosition.probabilities.resize(numHoles);
+    for (int i = 0; i < numHoles; i++) {
+        cachedPosition.probabilities[symmetries[symmetry][i]] =
+            probabilities[i];
+    }
+    cachedPosition.totalWeight = totalWeight;
+    cachedPosition.logScale = weightLogScale;
+    cachedPosition.iterations = totalIterations;
+    cachedPosition.legalIterations = legalIterations;
+    cachedPosition.partitions = numPartitions;
+    cachedPosition.sunkenPartitions = numSunkenPartitions;
+    cachedPosition.constrainedHoles = numConstrained;
+    cachedPosition.deducedHoles = deducedHoles;
+    if (transpositionCache != nullptr) {
+        transpositionCache->insert(cacheKey, cachedPosition);
+    }
+    if (persistentCache != nullptr) {
+        persistentCache->insert(cacheKey, cachedPosition);
+    }
+}
+
+// Certain holes were stored as exactly 0 or 1, so they are marked known here
+// just as solvePosition marked them.
+void Solver::applyCachedPosition(int symmetry)
+{
+    for (int i = 0; i < numHoles; i++) {
+        if (!isUnknown(i)) {
+            continue;
+        }
+        const double probability =
+            cachedPosition.probabilities[symmetries[symmetry][i]];
+        if (probability >= 1.0) {
+            setKnownBadSpot(i);
+        } else if (probability <= 0.0) {
+            setKnownSafeSpot(i);
+        } else {
+            badSpots[i] = false;
+            probabilities[i] = probability;
+        }
+    }
+    totalWeight = cachedPosition.totalWeight;
+    weightLogScale = cachedPosition.logScale;
+    totalIterations = cachedPosition.iterations;
+    legalIterations = cachedPosition.legalIterations;
+    numPartitions = cachedPosition.partitions;
+    numSunkenPartitions = cachedPosition.sunkenPartitions;
+    numConstrained = cachedPosition.constrainedHoles;
+    deducedHoles = cachedPosition.deducedHoles;
+}
+
+int Solver::deduce()
+{
+    int deduced = 0;
+    std::vector<int> safe;
+    std::vector<int> bad;
+    std::unordered_map<int, std::vector<Constraint *>> constraintsOfHole;
+    std::unordered_set<Constraint *> partners;
+    bool changed = true;
+    while (changed) {
+        removeDuplicateConstraints();
+        safe.clear();
+        bad.clear();
+        constraintsOfHole.clear();
+        for (Constraint *constraint : constraintList) {
+            for (int hole : constraint->holes) {
+                constraintsOfHole[hole].push_back(constraint);
             }
         }
-        if (badSpotsSeen != constraint->maxBadness &&
-            badSpotsSeen + 1 != constraint->maxBadness) {
-            return false;
+        for (Constraint *constraint : constraintList) {
+            classifyHoles(constraint->holes,
+                          std::max(constraint->maxBadness - 1, 0),
+                          constraint->maxBadness,
+                          safe,
+                          bad);
+            partners.clear();
+            for (int hole : constraint->holes) {
+                for (Constraint *other : constraintsOfHole[hole]) {
+                    if (other > constraint && partners.insert(other).second) {
+                        deducePair(*constraint, *other, safe, bad);
+                    }
+                }
+            }
+        }
+
+        changed = false;
+        for (int hole : safe) {
+            if (cell(hole).state == HoleState::constrained &&
+                std::find(bad.begin(), bad.end(), hole) == bad.end()) {
+                setKnownSafeSpot(hole);
+                deduced++;
+                changed = true;
+            }
+        }
+        for (int hole : bad) {
+            if (cell(hole).state == HoleState::constrained &&
+                std::find(safe.begin(), safe.end(), hole) == safe.end()) {
+                setKnownBadSpot(hole);
+                deduced++;
+                changed = true;
+            }
+        }
+    }
+    return deduced;
+}
+
+void Solver::removeDuplicateConstraints()
+{
+    std::map<std::pair<std::vector<int>, int>, Constraint *> seen;
+    std::vector<int> holes;
+    for (size_t i = 0; i < constraintList.size();) {
+        Constraint *constraint = constraintList[i];
+        holes = constraint->holes;
+        std::sort(holes.begin(), holes.end());
+        if (seen.emplace(std::make_pair(holes, constraint->maxBadness),
+                         constraint)
+                .second) {
+            i++;
+        } else {
+            deactivateConstraint(constraint);
+        }
+    }
+}
+
+void Solver::setEngine(Engine engine)
+{
+    this->engine = engine;
+}
+
+void Solver::setTranspositionCache(TranspositionCache *cache)
+{
+    transpositionCache = cache;
+}
+
+void Solver::setLogging(bool enabled)
+{
+    logging = enabled;
+}
+
+void Solver::setPublishing(bool enabled)
+{
+    publishing = enabled;
+}
+
+void Solver::setArithmetic(Arithmetic arithmetic)
+{
+    this->arithmetic = arithmetic;
+}
+
+void Solver::setPersistentCache(PersistentCache *cache)
+{
+    persistentCache = cache;
+}
+
+void Solver::setOpeningBook(std::shared_ptr<const OpeningBook> book)
+{
+    openingBook = std::move(book);
+}
+
+Solver::Engine Solver::activeEngine() const
+{
+    switch (engine) {
+    case Engine::automatic:
+        if (BoardDatabase::layoutCount(params_) <=
+                BoardDatabase::smallLayouts &&
+            BoardDatabase::isSuitable(params_)) {
+            return Engine::boardDatabase;
+        }
+        if (hasPresetSolver(params_)) {
+            return Engine::preset;
+        }
+        if (ColumnSweep::isSuitable(params_)) {
+            return Engine::columnSweep;
+        }
+        return Engine::variableElimination;
+    case Engine::preset:
+        return hasPresetSolver(params_) ? Engine::preset
+                                        : Engine::partitionEnumeration;
+    case Engine::columnSweep:
+        return ColumnSweep::isSuitable(params_) ? Engine::columnSweep
+                                                : Engine::partitionEnumeration;
+    case Engine::boardDatabase:
+        return BoardDatabase::isSuitable(params_)
+                   ? Engine::boardDatabase
+                   : Engine::partitionEnumeration;
+    default:
+        return engine;
+    }
+}
+
+Solver::Arithmetic Solver::activeArithmetic() const
+{
+    if (arithmetic == Arithmetic::floating ||
+        arithmetic == Arithmetic::logarithmic) {
+        return arithmetic;
+    }
+    // The weights of all configurations sum to at most the number of ways
+    // to place the remaining bad spots among the unknown holes, and a
+    // partition's bad weight to at most its size times that.
+    const int unknown = countHoles(HoleState::unconstrained) +
+                        countHoles(HoleState::constrained);
+    const int bad =
+        params_.bombs + params_.rupoors - countHoles(HoleState::knownBad);
+    if (bad < 0 || bad > unknown) {
+        return arithmetic == Arithmetic::exact ? Arithmetic::exact
+                                               : Arithmetic::floating;
+    }
+    const double logLayouts = std::lgamma(unknown + 1.0) -
+                              std::lgamma(bad + 1.0) -
+                              std::lgamma(unknown - bad + 1.0);
+    if (arithmetic == Arithmetic::exact) {
+        return logLayouts + std::log(unknown + 1.0) < maxExactLog
+                   ? Arithmetic::exact
+                   : Arithmetic::logarithmic;
+    }
+    return logLayouts < maxDoubleLog ? Arithmetic::floating
+                                     : Arithmetic::logarithmic;
+}
+
+void Solver::applyFrontierSolution()
+{
+    for (size_t i = 0; i < frontierProblem.holes.size(); i++) {
+        setProbability(frontierProblem.holes[i], frontierSolution.badWeight[i]);
+        addOutcomes(frontierProblem.holes[i], frontierSolution.outcomes[i]);
+    }
+    if (sparse) {
+        unconstrainedProbability = frontierSolution.unconstrainedBadWeight;
+        unconstrainedOutcomes = frontierSolution.unconstrainedOutcomes;
+    } else {
+        std::vector<int> unconstrained;
+        collectHoles(HoleState::unconstrained, unconstrained);
+        for (int hole : unconstrained) {
+            probabilities[hole] = frontierSolution.unconstrainedBadWeight;
+            outcomes[hole] = frontierSolution.unconstrainedOutcomes;
+        }
+    }
+    totalWeight = frontierSolution.totalWeight;
+    weightLogScale = frontierSolution.logScale;
+    totalIterations = frontierSolution.iterations;
+    legalIterations = frontierSolution.legalIterations;
+    numPartitions = frontierSolution.partitions;
+    numSunkenPartitions = 0;
+}
+
+// The database answers from the opened cells alone; deductions made so far
+// only agree with it.
+void Solver::lookUpDatabase()
+{
+    if (boardDatabase == nullptr) {
+        boardDatabase = BoardDatabase::forParameters(params_);
+    }
+    databaseBoard.resize(numHoles);
+    for (int i = 0; i < numHoles; i++) {
+        databaseBoard[i] = cell(i).type;
+    }
+    totalWeight = boardDatabase->solve(
+        databaseBoard.data(), databaseWeights, databaseScratch);
+    // The counts are whole numbers well within a double, so they compare
+    // exactly.
+    for (int i = 0; i < numHoles; i++) {
+        if (isUnknown(i)) {
+            setProbability(i, databaseWeights[i]);
+            addOutcomes(i,
+                        uint8_t((databaseWeights[i] > 0.0 ? Outcomes::bad : 0) |
+                                (databaseWeights[i] < totalWeight
+                                     ? Outcomes::safe
+                                     : 0)));
+        }
+    }
+    weightLogScale = 0.0;
+    totalIterations = 0;
+    legalIterations = int(totalWeight);
+    numPartitions = 0;
+    numSunkenPartitions = 0;
+}
+
+void Solver::enumeratePartitions()
+{
+    generatePartitions();
+    switch (activeArithmetic()) {
+    case Arithmetic::logarithmic:
+        enumerateWith<LogWeight>();
+        break;
+    case Arithmetic::exact:
+        enumerateWith<ExactWeight>();
+        break;
+    default:
+        enumerateWith<DoubleWeight>();
+        break;
+    }
+
+    double probability;
+    for (size_t i = 0; i < partitionList.size(); i++) {
+        probability =
+            partitionBadWeight[i] / double(partitionList[i]->holes.size());
+        addPartitionWeight(
+            partitionList[i], probability, partitionOutcomes[i]);
+    }
+    // A sunken partition's count is fixed, in every layout if there is one.
+    for (auto sunkenPartition : sunkenPartitions) {
+        probability = totalWeight * sunkenPartition->badness /
+                      double(sunkenPartition->holes.size());
+        addPartitionWeight(
+            sunkenPartition,
+            probability,
+            totalWeight > 0.0
+                ? Outcomes::ofCount(sunkenPartition->badness,
+                                    int(sunkenPartition->holes.size()))
+                : uint8_t(0));
+    }
+    numPartitions = int(partitionList.size() + sunkenPartitions.size());
+    numSunkenPartitions = int(sunkenPartitions.size());
+}
+
+// Sums the legal configurations in the arithmetic of Weight, then reads the
+// sums out as doubles under a common log scale.
+template <typename Weight>
+void Solver::enumerateWith()
+{
+    using Value = typename Weight::Value;
+    PartitionIterator<Weight> it(&partitionList,
+                                 badSpots,
+                                 &sunkenPartitions,
+                                 constraintList,
+                                 params_.bombs + params_.rupoors -
+                                     countHoles(HoleState::knownBad));
+
+    Value total = Weight::zero();
+    std::vector<Value> badWeights(partitionList.size(), Weight::zero());
+    partitionOutcomes.assign(partitionList.size(), 0);
+    totalIterations = 0;
+    legalIterations = 0;
+    do {
+        const Value &configurationWeight = it.iterate();
+        totalIterations++;
+        if (!it.isLegal()) {
+            continue;
+        }
+        legalIterations++;
+
+        Weight::add(total, configurationWeight);
+
+        // Outcomes come from the configurations that have layouts, told
+        // apart on the weight itself rather than on its conversion.
+        const bool possible = !Weight::isZero(configurationWeight);
+        for (size_t i = 0; i < partitionList.size(); i++) {
+            Weight::addMultiple(badWeights[i],
+                                configurationWeight,
+                                partitionList[i]->badness);
+            if (possible) {
+                partitionOutcomes[i] |=
+                    Outcomes::ofCount(partitionList[i]->badness,
+                                      int(partitionList[i]->holes.size()));
+            }
+        }
+
+    } while (it.hasNext());
+
+    weightLogScale = Weight::logScale(total);
+    totalWeight = Weight::toDouble(total, weightLogScale);
+    partitionBadWeight.resize(partitionList.size());
+    for (size_t i = 0; i < partitionList.size(); i++) {
+        partitionBadWeight[i] =
+            Weight::toDouble(badWeights[i], weightLogScale);
+    }
+}
+
+void Solver::buildFrontierProblem()
+{
+    std::unordered_map<int, int> positions;
+    collectHoles(HoleState::constrained, frontierProblem.holes);
+    for (size_t i = 0; i < frontierProblem.holes.size(); i++) {
+        positions[frontierProblem.holes[i]] = int(i);
+    }
+    frontierProblem.constraintHoles.resize(constraintList.size());
+    frontierProblem.maxBadness.resize(constraintList.size());
+    for (size_t c = 0; c < constraintList.size(); c++) {
+        std::vector<int> &holes = frontierProblem.constraintHoles[c];
+        holes.clear();
+        for (int hole : constraintList[c]->holes) {
+            holes.push_back(positions.at(hole));
         }
+        frontierProblem.maxBadness[c] = constraintList[c]->maxBadness;
     }
-    return true;
+    frontierProblem.unconstrainedHoles =
+        countHoles(HoleState::unconstrained);
+    frontierProblem.badSpots = params_.bombs + params_.rupoors -
+                               countHoles(HoleState::knownBad);
+}
+
+const std::vector<double> &Solver::getProbabilityArray() const
+{
+    if (sparse && !probabilitiesExpanded) {
+        expandProbabilities();
+    }
+    return probabilities;
+}
+
+double Solver::getProbability(int index)
+{
+    return probability(index);
+}
+
+std::shared_ptr<const SolverSnapshot> Solver::snapshot() const
+{
+    return std::atomic_load(&publishedSnapshot);
+}
+
+uint64_t Solver::getBoardGeneration() const
+{
+    return boardGeneration;
+}
+
+bool Solver::isStale(const SolverSnapshot &snapshot) const
+{
+    return snapshot.generation != boardGeneration;
 }
 
 double Solver::choose(uint64_t n, uint64_t k)
@@ -245,62 +1176,33 @@ double Solver::choose(uint64_t n, uint64_t k)
 
 void Solver::setKnownBadSpot(int index)
 {
-    knownBadSpots.insert(index);
+    setHoleState(index, HoleState::knownBad);
     badSpots[index] = true;
-    probabilities[index] = 1.0;
-    constrainedUnopenedHoles.erase(index);
-    unconstrainedUnopenedHoles.erase(index);
-    const int y = index / params_.width;
-    const int x = index % params_.width;
-    for (int filterY = y - 1; filterY < y + 2; filterY++) {
-        if (filterY >= 0 && filterY < params_.height) {
-            for (int filterX = x - 1; filterX < x + 2; filterX++) {
-                if ((filterX >= 0 && filterX < params_.width) &&
-                    (filterX != x || filterY != y)) {
-                    const int filterIndex = filterY * params_.width + filterX;
-                    if (board[filterIndex] > 0) {
-                        Constraint *constraint = &constraints[filterIndex];
-                        auto it = std::find(constraint->holes.begin(),
-                                            constraint->holes.end(),
-                                            index);
-                        if (constraint->maxBadness != -1 &&
-                            it != constraint->holes.end()) {
-                            constraint->holes.erase(it);
-                            constraint->maxBadness--;
-                            if (constraint->maxBadness == 0) {
-                                while (!constraint->holes.empty()) {
-                                    const int constrainedHole =
-                                        constraint->holes.back();
-                                    constraint->holes.pop_back();
-                                    setKnownSafeSpot(constrainedHole);
-                                }
-
-                                constraintList.erase(
-                                    std::remove(constraintList.begin(),
-                                                constraintList.end(),
-                                                constraint),
-                                    constraintList.end());
-
-                            } else if (constraint->holes.size() == 1 &&
-                                       constraint->maxBadness == 1) {
-                                const int unimportantHole =
-                                    constraint->holes.at(0);
-                                imposingConstraints[unimportantHole].erase(
-                                    constraint);
-                                constraintList.erase(
-                                    std::remove(constraintList.begin(),
-                                                constraintList.end(),
-                                                constraint),
-                                    constraintList.end());
-                                if (imposingConstraints[unimportantHole]
-                                        .empty()) {
-                                    constrainedUnopenedHoles.erase(
-                                        unimportantHole);
-                                    unconstrainedUnopenedHoles.insert(
-                                        unimportantHole);
-                                }
-                            }
-                        }
+    setProbability(index, 1.0);
+    const NeighborTable::Range range = (*neighbors)[index];
+    const int *reverseSlots = neighbors->reverseSlots(index);
+    for (int k = 0; k < range.size(); k++) {
+        const int filterIndex = range.first[k];
+        if (cell(filterIndex).type > 0) {
+            Constraint *constraint = &constraintAt(filterIndex);
+            if (constraint->maxBadness != -1 &&
+                constraint->hasHoleAt(reverseSlots[k])) {
+                constraint->removeHoleAt(reverseSlots[k]);
+                constraint->maxBadness--;
+                if (constraint->maxBadness == 0) {
+                    while (!constraint->holes.empty()) {
+                        setKnownSafeSpot(constraint->popHole());
+                    }
+                    deactivateConstraint(constraint);
+
+                } else if (constraint->holes.size() == 1 &&
+                           constraint->maxBadness == 1) {
+                    const int unimportantHole = constraint->holes.at(0);
+                    imposingConstraintsOf(unimportantHole).erase(constraint);
+                    deactivateConstraint(constraint);
+                    if (imposingConstraintsOf(unimportantHole).empty()) {
+                        setHoleState(unimportantHole,
+                                     HoleState::unconstrained);
                     }
                 }
             }
@@ -310,68 +1212,34 @@ void Solver::setKnownBadSpot(int index)
 
 void Solver::setKnownSafeSpot(int index)
 {
-    knownSafeSpots.insert(index);
-    constrainedUnopenedHoles.erase(index);
-    unconstrainedUnopenedHoles.erase(index);
-    probabilities[index] = 0.0;
+    setHoleState(index, HoleState::knownSafe);
+    setProbability(index, 0.0);
     badSpots[index] = false;
     Constraint *constraint;
-    int constrainedHole;
-    int filterIndex;
     int unimportantHole;
-    int y = index / params_.width;
-    int x = index % params_.width;
-    for (int filterY = y - 1; filterY < y + 2; filterY++) {
-        if (filterY >= 0 && filterY < params_.height) {
-            for (int filterX = x - 1; filterX < x + 2; filterX++) {
-                if ((filterX >= 0 && filterX < params_.width) &&
-                    (filterX != x || filterY != y)) {
-                    filterIndex = filterY * params_.width + filterX;
-                    if (board[filterIndex] > 0) {
-                        constraint = &constraints[filterIndex];
-                        auto constrainedHoleIt =
-                            std::find(constraint->holes.begin(),
-                                      constraint->holes.end(),
-                                      index);
-                        if (constraint->maxBadness != -1 &&
-                            constrainedHoleIt != constraint->holes.end()) {
-                            constraint->holes.erase(constrainedHoleIt);
-                            if (constraint->maxBadness - 1 ==
-                                int(constraint->holes.size())) {
-                                while (!constraint->holes.empty()) {
-                                    constrainedHole = constraint->holes.back();
-                                    constraint->holes.pop_back();
-                                    setKnownBadSpot(constrainedHole);
-                                }
-                                auto it = std::find(constraintList.begin(),
-                                                    constraintList.end(),
-                                                    constraint);
-                                if (it != constraintList.end()) {
-                                    constraintList.erase(it);
-                                }
-                            } else if (constraint->holes.size() == 1 &&
-                                       constraint->maxBadness == 1) {
-                                unimportantHole = constraint->holes.back();
-                                constraint->holes.pop_back();
-                                imposingConstraints[unimportantHole].erase(
-                                    constraint);
-                                auto trivialConstraintIt =
-                                    std::find(constraintList.begin(),
-                                              constraintList.end(),
-                                              constraint);
-                                if (trivialConstraintIt !=
-                                    constraintList.end()) {
-                                    constraintList.erase(trivialConstraintIt);
-                                }
-                                if (imposingConstraints[unimportantHole]
-                                        .empty()) {
-                                    constrainedUnopenedHoles.erase(
-                                        unimportantHole);
-                                    unconstrainedUnopenedHoles.insert(
-                                        unimportantHole);
-                                }
-                            }
-                        }
+    const NeighborTable::Range range = (*neighbors)[index];
+    const int *reverseSlots = neighbors->reverseSlots(index);
+    for (int k = 0; k < range.size(); k++) {
+        const int filterIndex = range.first[k];
+        if (cell(filterIndex).type > 0) {
+            constraint = &constraintAt(filterIndex);
+            if (constraint->maxBadness != -1 &&
+                constraint->hasHoleAt(reverseSlots[k])) {
+                constraint->removeHoleAt(reverseSlots[k]);
+                if (constraint->maxBadness - 1 ==
+                    int(constraint->holes.size())) {
+                    while (!constraint->holes.empty()) {
+                        setKnownBadSpot(constraint->popHole());
+                    }
+                    deactivateConstraint(constraint);
+                } else if (constraint->holes.size() == 1 &&
+                           constraint->maxBadness == 1) {
+                    unimportantHole = constraint->popHole();
+                    imposingConstraintsOf(unimportantHole).erase(constraint);
+                    deactivateConstraint(constraint);
+                    if (imposingConstraintsOf(unimportantHole).empty()) {
+                        setHoleState(unimportantHole,
+                                     HoleState::unconstrained);
                     }
                 }
             }
@@ -379,6 +1247,51 @@ void Solver::setKnownSafeSpot(int index)
     }
 }
 
+void Solver::activateConstraint(Constraint *constraint)
+{
+    constraint->listPosition = int(constraintList.size());
+    constraintList.push_back(constraint);
+}
+
+void Solver::deactivateConstraint(Constraint *constraint)
+{
+    const int position = constraint->listPosition;
+    if (position == -1) {
+        return;
+    }
+    constraintList[position] = constraintList.back();
+    constraintList[position]->listPosition = position;
+    constraintList.pop_back();
+    constraint->listPosition = -1;
+}
+
+// Applies the rules setKnownSafeSpot and setKnownBadSpot apply when a hole
+// leaves a constraint; the marks cascade from there to a fixed point.
+void Solver::settleConstraint(Constraint *constraint)
+{
+    if (constraint->holes.empty()) {
+        return;
+    }
+    if (constraint->maxBadness == 0) {
+        while (!constraint->holes.empty()) {
+            setKnownSafeSpot(constraint->popHole());
+        }
+        deactivateConstraint(constraint);
+    } else if (constraint->maxBadness - 1 == int(constraint->holes.size())) {
+        while (!constraint->holes.empty()) {
+            setKnownBadSpot(constraint->popHole());
+        }
+        deactivateConstraint(constraint);
+    } else if (constraint->holes.size() == 1 && constraint->maxBadness == 1) {
+        const int unimportantHole = constraint->popHole();
+        imposingConstraintsOf(unimportantHole).erase(constraint);
+        deactivateConstraint(constraint);
+        if (imposingConstraintsOf(unimportantHole).empty()) {
+            setHoleState(unimportantHole, HoleState::unconstrained);
+        }
+    }
+}
+
 void Solver::generatePartitions()
 {
 
@@ -387,9 +1300,14 @@ void Solver::generatePartitions()
     Partition *partition;
     bool present;
     int numpartitions = 0;
-    for (int constrainedHole : constrainedUnopenedHoles) {
+    std::vector<int> holes;
+    collectHoles(HoleState::constrained, holes);
+    if (partitions.size() < holes.size() + 1) {
+        partitions.resize(holes.size() + 1);
+    }
+    for (int constrainedHole : holes) {
         partition = &partitions[numpartitions];
-        partition->constraints = imposingConstraints[constrainedHole];
+        partition->constraints = imposingConstraintsOf(constrainedHole);
         partition->holes.clear();
         present = false;
         for (auto i : partitionList) {
@@ -407,11 +1325,10 @@ void Solver::generatePartitions()
             numpartitions++;
         }
     }
-    if (!unconstrainedUnopenedHoles.empty()) {
+    if (countHoles(HoleState::unconstrained) > 0) {
         partition = &partitions[numpartitions];
         partition->constraints = Solver::emptySet;
-        partition->holes = {unconstrainedUnopenedHoles.begin(),
-                            unconstrainedUnopenedHoles.end()};
+        collectHoles(HoleState::unconstrained, partition->holes);
         partitionList.insert(partitionList.begin(), partition);
     }
 }
@@ -422,7 +1339,8 @@ int Solver::getConstrainedHoles()
 
 double Solver::getTotalNumConfigurations()
 {
-    return totalWeight;
+    return weightLogScale == 0.0 ? totalWeight
+                                 : totalWeight * std::exp(weightLogScale);
 }
 
 uint64_t Solver::getIterations()
@@ -437,5 +1355,41 @@ int Solver::getLegalIterations()
 
 int Solver::getPartitions()
 {
-    return int(partitionList.size() + sunkenPartitions.size());
+    return numPartitions;
+}
+
+int Solver::getSunkenPartitions()
+{
+    return numSunkenPartitions;
+}
+
+int Solver::getDeducedHoles()
+{
+    return deducedHoles;
+}
+
+uint64_t Solver::getCacheHits()
+{
+    return cacheHits;
+}
+
+uint64_t Solver::getCacheLookups()
+{
+    return cacheLookups;
+}
+
+DugType::DugType Solver::getCellType(int index)
+{
+    return cell(index).type;
+}
+
+Solver::HoleState Solver::getHoleState(int index)
+{
+    return cell(index).state;
+}
+
+const FrontierProblem &Solver::getFrontierProblem()
+{
+    buildFrontierProblem();
+    return frontierProblem;
 }
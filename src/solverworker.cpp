@@ -0,0 +1,68 @@
+#include "headers/solverworker.h"
+
+#include "headers/openingbook.h"
+#include <QMetaObject>
+#include <algorithm>
+
+SolverWorker::SolverWorker(const ProblemParameters &params,
+                           bool keepPositions)
+    : params_(params),
+      solver_(params),
+      board_(params.width * params.height, DugType::undug)
+{
+    if (keepPositions) {
+        persistentCache_ = std::make_unique<PersistentCache>(
+            PersistentCache::defaultPath(params), params);
+        solver_.setPersistentCache(persistentCache_.get());
+    }
+    solver_.setTranspositionCache(&TranspositionCache::shared());
+    solver_.setOpeningBook(OpeningBook::forParameters(params));
+    // The window reads every result through a snapshot, whatever the
+    // solver's storage.
+    solver_.setPublishing(true);
+    // Members are not children, so the solver is moved along explicitly.
+    moveToThread(&thread_);
+    solver_.moveToThread(&thread_);
+    thread_.start();
+}
+
+SolverWorker::~SolverWorker()
+{
+    thread_.quit();
+    thread_.wait();
+}
+
+std::shared_ptr<const SolverSnapshot> SolverWorker::snapshot() const
+{
+    return solver_.snapshot();
+}
+
+void SolverWorker::setCell(int x, int y, int type, quint64 generation)
+{
+    board_[y * params_.width + x] = DugType::DugType(type);
+    generation_ = std::max(generation_, generation);
+    schedule();
+}
+
+void SolverWorker::requestSolve(quint64 generation)
+{
+    generation_ = std::max(generation_, generation);
+    schedule();
+}
+
+void SolverWorker::schedule()
+{
+    if (!scheduled_) {
+        scheduled_ = true;
+        QMetaObject::invokeMethod(this, "solvePending", Qt::QueuedConnection);
+    }
+}
+
+void SolverWorker::solvePending()
+{
+    scheduled_ = false;
+    const quint64 generation = generation_;
+    solver_.loadBoard(board_.data());
+    solver_.partitionCalculate();
+    emit solved(generation);
+}
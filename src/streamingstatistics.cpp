@@ -0,0 +1,76 @@
+#include "headers/streamingstatistics.h"
+
+#include <algorithm>
+
+StreamingStatistics::StreamingStatistics(double lower,
+                                         double upper,
+                                         int buckets)
+    : lower_(lower), upper_(upper), histogram_(std::max(buckets, 1), 0)
+{
+}
+
+void StreamingStatistics::add(double value)
+{
+    count_++;
+    const double delta = value - mean_;
+    mean_ += delta / double(count_);
+    m2_ += delta * (value - mean_);
+
+    const int buckets = int(histogram_.size());
+    int bucket = int((value - lower_) / (upper_ - lower_) * buckets);
+    bucket = std::clamp(bucket, 0, buckets - 1);
+    histogram_[bucket]++;
+}
+
+void StreamingStatistics::merge(const StreamingStatistics &other)
+{
+    if (other.count_ == 0) {
+        return;
+    }
+    const uint64_t total = count_ + other.count_;
+    const double delta = other.mean_ - mean_;
+    mean_ += delta * double(other.count_) / double(total);
+    m2_ += other.m2_ + delta * delta * double(count_) *
+                           double(other.count_) / double(total);
+    count_ = total;
+    for (size_t i = 0; i < histogram_.size() && i < other.histogram_.size();
+         i++) {
+        histogram_[i] += other.histogram_[i];
+    }
+}
+
+uint64_t StreamingStatistics::count() const
+{
+    return count_;
+}
+
+double StreamingStatistics::mean() const
+{
+    return mean_;
+}
+
+double StreamingStatistics::variance() const
+{
+    return count_ > 1 ? m2_ / double(count_ - 1) : 0.0;
+}
+
+double StreamingStatistics::quantile(double q) const
+{
+    if (count_ == 0) {
+        return 0.0;
+    }
+    const double bucketWidth = (upper_ - lower_) / double(histogram_.size());
+    const double target = std::clamp(q, 0.0, 1.0) * double(count_);
+    double seen = 0.0;
+    for (size_t i = 0; i < histogram_.size(); i++) {
+        if (histogram_[i] == 0) {
+            continue;
+        }
+        if (seen + double(histogram_[i]) >= target) {
+            const double fraction = (target - seen) / double(histogram_[i]);
+            return lower_ + (double(i) + fraction) * bucketWidth;
+        }
+        seen += double(histogram_[i]);
+    }
+    return upper_;
+}
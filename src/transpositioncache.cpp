@@ -0,0 +1,145 @@
+#include "headers/transpositioncache.h"
+
+namespace
+{
+
+uint64_t splitMix(uint64_t value)
+{
+    value += 0x9e3779b97f4a7c15ull;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+// Zobrist key of a dug cell, derived instead of drawn from a table so that
+// every board shape gets one for free.
+uint64_t zobrist(int cell, DugType::DugType type)
+{
+    return splitMix(uint64_t(cell) * 16 + uint64_t(type - DugType::undug));
+}
+
+} // namespace
+
+bool TranspositionCache::Key::operator==(const Key &other) const
+{
+    return hash == other.hash && width == other.width &&
+           height == other.height && bombs == other.bombs &&
+           rupoors == other.rupoors && board == other.board;
+}
+
+TranspositionCache::TranspositionCache(size_t capacity) : capacity_(capacity)
+{
+}
+
+TranspositionCache &TranspositionCache::shared()
+{
+    static TranspositionCache cache;
+    return cache;
+}
+
+std::vector<std::vector<int>> TranspositionCache::symmetries(int width,
+                                                             int height)
+{
+    const int count = width == height ? 8 : 4;
+    std::vector<std::vector<int>> result(count,
+                                         std::vector<int>(width * height));
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const int mirroredX = width - 1 - x;
+            const int mirroredY = height - 1 - y;
+            const int index = y * width + x;
+            result[0][index] = index;
+            result[1][index] = y * width + mirroredX;
+            result[2][index] = mirroredY * width + x;
+            result[3][index] = mirroredY * width + mirroredX;
+            if (count == 8) {
+                result[4][index] = x * width + y;
+                result[5][index] = x * width + mirroredY;
+                result[6][index] = mirroredX * width + y;
+                result[7][index] = mirroredX * width + mirroredY;
+            }
+        }
+    }
+    return result;
+}
+
+int TranspositionCache::makeKey(const ProblemParameters &params,
+                                const std::vector<std::vector<int>> &symmetries,
+                                const std::vector<DugType::DugType> &types,
+                                Key &key)
+{
+    const uint64_t parameterHash =
+        splitMix(splitMix(splitMix(splitMix(uint64_t(params.width)) ^
+                                   uint64_t(params.height)) ^
+                          uint64_t(params.bombs)) ^
+                 uint64_t(params.rupoors));
+    int best = 0;
+    uint64_t bestHash = 0;
+    for (int s = 0; s < int(symmetries.size()); s++) {
+        uint64_t hash = parameterHash;
+        for (int i = 0; i < int(types.size()); i++) {
+            if (types[i] != DugType::undug) {
+                hash ^= zobrist(symmetries[s][i], types[i]);
+            }
+        }
+        if (s == 0 || hash < bestHash) {
+            best = s;
+            bestHash = hash;
+        }
+    }
+
+    key.hash = bestHash;
+    key.width = params.width;
+    key.height = params.height;
+    key.bombs = params.bombs;
+    key.rupoors = params.rupoors;
+    key.board.resize(types.size());
+    for (int i = 0; i < int(types.size()); i++) {
+        key.board[symmetries[best][i]] = types[i];
+    }
+    return best;
+}
+
+bool TranspositionCache::find(const Key &key, Position &position)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    lookups_++;
+    auto found = index_.find(key.hash);
+    if (found == index_.end() || !(found->second->key == key)) {
+        return false;
+    }
+    entries_.splice(entries_.begin(), entries_, found->second);
+    position = found->second->position;
+    hits_++;
+    return true;
+}
+
+void TranspositionCache::insert(const Key &key, const Position &position)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = index_.find(key.hash);
+    if (found != index_.end()) {
+        found->second->key = key;
+        found->second->position = position;
+        entries_.splice(entries_.begin(), entries_, found->second);
+        return;
+    }
+    entries_.push_front({key, position});
+    index_.emplace(key.hash, entries_.begin());
+    if (entries_.size() > capacity_) {
+        index_.erase(entries_.back().key.hash);
+        entries_.pop_back();
+    }
+}
+
+uint64_t TranspositionCache::hits() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+uint64_t TranspositionCache::lookups() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lookups_;
+}
@@ -0,0 +1,436 @@
+#include "headers/variableelimination.h"
+
+#include <algorithm>
+#include <map>
+
+bool VariableElimination::solve(const FrontierProblem &problem,
+                                FrontierSolution &solution)
+{
+    const int numFrontier = int(problem.holes.size());
+    badSpots_ = problem.badSpots;
+    const bool feasible = badSpots_ >= 0 && buildFactors(problem);
+    if (feasible && !chooseOrder()) {
+        return false;
+    }
+
+    solution.badWeight.assign(numFrontier, 0.0);
+    solution.outcomes.assign(numFrontier, 0);
+    solution.unconstrainedBadWeight = 0.0;
+    solution.unconstrainedOutcomes = 0;
+    solution.totalWeight = 0.0;
+    solution.logScale = 0.0;
+    solution.iterations = 0;
+    solution.legalIterations = 0;
+    solution.partitions = 0;
+    if (!feasible) {
+        return true;
+    }
+
+    int unconstrainedHoles = problem.unconstrainedHoles;
+    for (int i = 0; i < numFrontier; i++) {
+        if (partitionOfHole_[i] == -1) {
+            unconstrainedHoles++;
+        }
+    }
+    solution.logScale =
+        buildCompletions(unconstrainedHoles, badSpots_, completions_);
+    values_.assign(numPartitions_, 0);
+    entries_ = 0;
+
+    const std::vector<double> counts = eliminate();
+    for (int c = 0; c < int(counts.size()); c++) {
+        const double weight = counts[c] * completions_[c];
+        if (weight == 0.0) {
+            continue;
+        }
+        solution.totalWeight += weight;
+        solution.unconstrainedOutcomes |=
+            Outcomes::ofCount(badSpots_ - c, unconstrainedHoles);
+        if (unconstrainedHoles > 0) {
+            solution.unconstrainedBadWeight +=
+                weight * (badSpots_ - c) / unconstrainedHoles;
+        }
+    }
+
+    std::vector<double> partitionBadWeight(numPartitions_, 0.0);
+    std::vector<uint8_t> partitionOutcomes(numPartitions_, 0);
+    distribute(partitionBadWeight, partitionOutcomes);
+    for (int i = 0; i < numFrontier; i++) {
+        const int partition = partitionOfHole_[i];
+        if (partition == -1) {
+            solution.badWeight[i] = solution.unconstrainedBadWeight;
+            solution.outcomes[i] = solution.unconstrainedOutcomes;
+        } else {
+            solution.badWeight[i] =
+                partitionBadWeight[partition] / partitionSize_[partition];
+            solution.outcomes[i] = partitionOutcomes[partition];
+        }
+    }
+    solution.iterations = entries_;
+    solution.legalIterations = int(entries_);
+    solution.partitions = numPartitions_ + (unconstrainedHoles > 0 ? 1 : 0);
+    return true;
+}
+
+bool VariableElimination::buildFactors(const FrontierProblem &problem)
+{
+    const int numFrontier = int(problem.holes.size());
+    const int numConstraints = int(problem.constraintHoles.size());
+    std::vector<std::vector<int>> membership(numFrontier);
+    for (int c = 0; c < numConstraints; c++) {
+        for (int position : problem.constraintHoles[c]) {
+            membership[position].push_back(c);
+        }
+    }
+
+    std::map<std::vector<int>, int> partitions;
+    partitionOfHole_.assign(numFrontier, -1);
+    partitionSize_.clear();
+    for (int i = 0; i < numFrontier; i++) {
+        if (membership[i].empty()) {
+            continue;
+        }
+        auto inserted =
+            partitions.emplace(membership[i], int(partitionSize_.size()));
+        if (inserted.second) {
+            partitionSize_.push_back(0);
+        }
+        partitionOfHole_[i] = inserted.first->second;
+        partitionSize_[inserted.first->second]++;
+    }
+    numPartitions_ = int(partitionSize_.size());
+
+    adjacent_.assign(numPartitions_, std::set<int>());
+    constraintFactors_.clear();
+    for (int c = 0; c < numConstraints; c++) {
+        const int maxBadness = problem.maxBadness[c];
+        Factor factor;
+        for (int position : problem.constraintHoles[c]) {
+            factor.scope.push_back(partitionOfHole_[position]);
+        }
+        std::sort(factor.scope.begin(), factor.scope.end());
+        factor.scope.erase(
+            std::unique(factor.scope.begin(), factor.scope.end()),
+            factor.scope.end());
+        if (factor.scope.empty()) {
+            if (maxBadness > 1) {
+                return false;
+            }
+            continue;
+        }
+        for (int a : factor.scope) {
+            for (int b : factor.scope) {
+                if (a != b) {
+                    adjacent_[a].insert(b);
+                }
+            }
+        }
+
+        // Every hole of a partition is in the same constraints, so the bad
+        // count of a constraint is the sum of its partitions' bad counts.
+        int entries = 1;
+        for (int p : factor.scope) {
+            entries *= partitionSize_[p] + 1;
+        }
+        factor.table.resize(entries);
+        std::vector<int> values(factor.scope.size(), 0);
+        for (int entry = 0; entry < entries; entry++) {
+            int bad = 0;
+            for (int value : values) {
+                bad += value;
+            }
+            if (bad == maxBadness || bad + 1 == maxBadness) {
+                factor.table[entry].assign(1, 1.0);
+            }
+            for (int i = int(values.size()) - 1; i >= 0; i--) {
+                if (++values[i] <= partitionSize_[factor.scope[i]]) {
+                    break;
+                }
+                values[i] = 0;
+            }
+        }
+        constraintFactors_.push_back(std::move(factor));
+    }
+    return true;
+}
+
+bool VariableElimination::chooseOrder()
+{
+    std::vector<std::set<int>> graph = adjacent_;
+    std::vector<bool> eliminated(numPartitions_, false);
+    order_.clear();
+    for (int step = 0; step < numPartitions_; step++) {
+        int best = -1;
+        int bestFill = 0;
+        for (int v = 0; v < numPartitions_; v++) {
+            if (eliminated[v]) {
+                continue;
+            }
+            int fill = 0;
+            for (auto a = graph[v].begin(); a != graph[v].end(); ++a) {
+                for (auto b = std::next(a); b != graph[v].end(); ++b) {
+                    if (!graph[*a].count(*b)) {
+                        fill++;
+                    }
+                }
+            }
+            if (best == -1 || fill < bestFill ||
+                (fill == bestFill && graph[v].size() < graph[best].size())) {
+                best = v;
+                bestFill = fill;
+            }
+        }
+
+        double entries = 1.0;
+        for (int u : graph[best]) {
+            entries *= partitionSize_[u] + 1;
+        }
+        if (entries > maxFactorEntries) {
+            return false;
+        }
+        for (int a : graph[best]) {
+            graph[a].erase(best);
+            for (int b : graph[best]) {
+                if (a != b) {
+                    graph[a].insert(b);
+                }
+            }
+        }
+        graph[best].clear();
+        eliminated[best] = true;
+        order_.push_back(best);
+    }
+    return true;
+}
+
+std::vector<double> VariableElimination::eliminate()
+{
+    std::vector<Factor> factors = constraintFactors_;
+    std::vector<int> sources(factors.size(), -1);
+    buckets_.assign(numPartitions_, std::vector<Factor>());
+    bucketSources_.assign(numPartitions_, std::vector<int>());
+    downward_.assign(numPartitions_, Factor());
+    std::vector<double> product;
+    for (int v : order_) {
+        std::vector<Factor> &bucket = buckets_[v];
+        for (size_t i = 0; i < factors.size();) {
+            if (std::binary_search(
+                    factors[i].scope.begin(), factors[i].scope.end(), v)) {
+                bucket.push_back(std::move(factors[i]));
+                bucketSources_[v].push_back(sources[i]);
+                if (i + 1 != factors.size()) {
+                    factors[i] = std::move(factors.back());
+                    sources[i] = sources.back();
+                }
+                factors.pop_back();
+                sources.pop_back();
+            } else {
+                i++;
+            }
+        }
+
+        Factor result;
+        for (const Factor &factor : bucket) {
+            for (int u : factor.scope) {
+                if (u != v) {
+                    result.scope.push_back(u);
+                }
+            }
+        }
+        std::sort(result.scope.begin(), result.scope.end());
+        result.scope.erase(
+            std::unique(result.scope.begin(), result.scope.end()),
+            result.scope.end());
+        int entries = 1;
+        for (int u : result.scope) {
+            entries *= partitionSize_[u] + 1;
+            values_[u] = 0;
+        }
+        result.table.resize(entries);
+
+        const int size = partitionSize_[v];
+        for (int entry = 0; entry < entries; entry++) {
+            std::vector<double> &sum = result.table[entry];
+            double weight = 1.0;
+            for (int k = 0; k <= size && k <= badSpots_; k++) {
+                values_[v] = k;
+                if (k > 0) {
+                    weight = weight * (size - k + 1) / k;
+                }
+                product.assign(k + 1, 0.0);
+                product[k] = weight;
+                for (const Factor &factor : bucket) {
+                    multiply(product, factor.table[entryIndex(factor)]);
+                    if (product.empty()) {
+                        break;
+                    }
+                }
+                if (sum.size() < product.size()) {
+                    sum.resize(product.size(), 0.0);
+                }
+                for (size_t c = 0; c < product.size(); c++) {
+                    sum[c] += product[c];
+                }
+            }
+            entries_++;
+            for (int i = int(result.scope.size()) - 1; i >= 0; i--) {
+                const int u = result.scope[i];
+                if (++values_[u] <= partitionSize_[u]) {
+                    break;
+                }
+                values_[u] = 0;
+            }
+        }
+        downward_[v].scope = result.scope;
+        factors.push_back(std::move(result));
+        sources.push_back(v);
+    }
+
+    // What is left are the scopeless messages of the independent parts of
+    // the frontier. Each part is passed down the product of all the others.
+    const int roots = int(factors.size());
+    std::vector<std::vector<double>> prefix(roots + 1);
+    prefix[0].assign(1, 1.0);
+    for (int i = 0; i < roots; i++) {
+        prefix[i + 1] = prefix[i];
+        multiply(prefix[i + 1], factors[i].table[0]);
+    }
+    std::vector<double> suffix(1, 1.0);
+    for (int i = roots - 1; i >= 0; i--) {
+        if (sources[i] != -1) {
+            std::vector<double> others = prefix[i];
+            multiply(others, suffix);
+            downward_[sources[i]].table.assign(1, std::move(others));
+        }
+        multiply(suffix, factors[i].table[0]);
+    }
+    return prefix[roots];
+}
+
+void VariableElimination::distribute(std::vector<double> &partitionBadWeight,
+                                     std::vector<uint8_t> &partitionOutcomes)
+{
+    // Walks the buckets in reverse elimination order. The product of a
+    // bucket with its downward message covers the whole board, so weighting
+    // it by the partition's bad count gives that partition's marginal, and
+    // leaving out one child's message gives the downward message of that
+    // child. A bad count is possible when some total count it is part of
+    // has a completion.
+    std::vector<std::vector<double>> prefix;
+    std::vector<double> suffix;
+    std::vector<double> badCounts;
+    for (auto it = order_.rbegin(); it != order_.rend(); ++it) {
+        const int v = *it;
+        const std::vector<Factor> &bucket = buckets_[v];
+        const std::vector<int> &bucketSources = bucketSources_[v];
+        const Factor &down = downward_[v];
+        for (int child : bucketSources) {
+            if (child == -1) {
+                continue;
+            }
+            int entries = 1;
+            for (int u : downward_[child].scope) {
+                entries *= partitionSize_[u] + 1;
+            }
+            downward_[child].table.assign(entries, std::vector<double>());
+        }
+        for (int u : down.scope) {
+            values_[u] = 0;
+        }
+
+        badCounts.clear();
+        const int size = partitionSize_[v];
+        const int count = int(bucket.size());
+        prefix.resize(count + 1);
+        for (int entry = 0; entry < int(down.table.size()); entry++) {
+            double weight = 1.0;
+            for (int k = 0; k <= size && k <= badSpots_; k++) {
+                values_[v] = k;
+                if (k > 0) {
+                    weight = weight * (size - k + 1) / k;
+                }
+                prefix[0].assign(k + 1, 0.0);
+                prefix[0][k] = weight;
+                multiply(prefix[0], down.table[entry]);
+                for (int i = 0; i < count; i++) {
+                    prefix[i + 1] = prefix[i];
+                    multiply(prefix[i + 1],
+                             bucket[i].table[entryIndex(bucket[i])]);
+                }
+                if (prefix[count].size() > badCounts.size()) {
+                    badCounts.resize(prefix[count].size(), 0.0);
+                }
+                for (size_t c = 0; c < prefix[count].size(); c++) {
+                    badCounts[c] += prefix[count][c] * k;
+                    if (prefix[count][c] * completions_[c] > 0.0) {
+                        partitionOutcomes[v] |= Outcomes::ofCount(k, size);
+                    }
+                }
+
+                suffix.assign(1, 1.0);
+                for (int i = count - 1; i >= 0; i--) {
+                    const int child = bucketSources[i];
+                    if (child != -1 && !prefix[i].empty()) {
+                        std::vector<double> others = prefix[i];
+                        multiply(others, suffix);
+                        std::vector<double> &sum =
+                            downward_[child].table[entryIndex(bucket[i])];
+                        if (sum.size() < others.size()) {
+                            sum.resize(others.size(), 0.0);
+                        }
+                        for (size_t c = 0; c < others.size(); c++) {
+                            sum[c] += others[c];
+                        }
+                    }
+                    multiply(suffix, bucket[i].table[entryIndex(bucket[i])]);
+                }
+            }
+            entries_++;
+            for (int i = int(down.scope.size()) - 1; i >= 0; i--) {
+                const int u = down.scope[i];
+                if (++values_[u] <= partitionSize_[u]) {
+                    break;
+                }
+                values_[u] = 0;
+            }
+        }
+        for (int c = 0; c < int(badCounts.size()); c++) {
+            partitionBadWeight[v] += badCounts[c] * completions_[c];
+        }
+        buckets_[v].clear();
+        downward_[v].table.clear();
+    }
+}
+
+int VariableElimination::entryIndex(const Factor &factor) const
+{
+    int index = 0;
+    for (int u : factor.scope) {
+        index = index * (partitionSize_[u] + 1) + values_[u];
+    }
+    return index;
+}
+
+void VariableElimination::multiply(std::vector<double> &product,
+                                   const std::vector<double> &factor) const
+{
+    if (product.empty() || factor.empty()) {
+        product.clear();
+        return;
+    }
+    if (factor.size() == 1) {
+        for (double &value : product) {
+            value *= factor[0];
+        }
+        return;
+    }
+    const size_t length = std::min(product.size() + factor.size() - 1,
+                                   size_t(badSpots_ + 1));
+    std::vector<double> result(length, 0.0);
+    for (size_t a = 0; a < product.size(); a++) {
+        for (size_t b = 0; b < factor.size() && a + b < length; b++) {
+            result[a + b] += product[a] * factor[b];
+        }
+    }
+    product.swap(result);
+}
@@ -15,6 +15,8 @@ public:
     {
         vector_[y * width + x] = value;
     }
+    const T &operator[](size_t index) const & { return vector_[index]; }
+    T &operator[](size_t index) & { return vector_[index]; }
 
     auto begin() { return vector_.begin(); }
     auto end() { return vector_.end(); }